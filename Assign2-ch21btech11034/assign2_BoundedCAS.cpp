@@ -8,10 +8,23 @@
 #include <atomic>
 #include <algorithm>
 #include <thread> 
+#include "chrome_trace.h"
+#include "perf_counters.h"
+#include "cas_telemetry.h"
 
 using namespace std;
 using namespace std::chrono;
 
+// Compile-time instrumentation level, set with -DTRACE_LEVEL=<n> (see Makefile):
+//   0 (none)     - no per-event logging and no timestamps; only the total time is measured
+//   1 (counters) - CS entry/exit timing statistics, no log lines
+//   2 (full)     - timing statistics plus the per-event log written to the output file
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL 2
+#endif
+constexpr bool traceCounters = TRACE_LEVEL >= 1;
+constexpr bool traceFull = TRACE_LEVEL >= 2;
+
 int N, K, taskInc;
 vector<vector<int>> sudoku;
 vector<string> Buffers;
@@ -48,6 +61,9 @@ public:
     long long worst_cs_entry;
     long long worst_cs_exit;
     int cs_count;
+    CasTelemetry cas;
+    PerfSample perf;
+    string perf_error;
 
     thread_data()
     {
@@ -74,6 +90,20 @@ void writeOutputToFile(const string &output)
     outFile.close();
 }
 
+long long timestampNow()
+{
+    return duration_cast<nanoseconds>(high_resolution_clock::now().time_since_epoch()).count() - base_timestamp;
+}
+
+// Timestamp for a log line; compiled out below the full trace level
+inline long long traceTimestamp()
+{
+    if constexpr (traceFull)
+        return timestampNow();
+    else
+        return 0;
+}
+
 vector<string> splitByNewline(const string &buffer)
 {
     vector<string> lines;
@@ -117,36 +147,61 @@ void parseAndWriteLogs(const vector<string> &buffers)
 }
 
 
+// compare_exchange_weak that also feeds the thread's CAS telemetry at the counters level
+bool casClaim(thread_data *tdata, atomic<int> &counter, int &current, int desired)
+{
+    int expected = current;
+    bool ok = counter.compare_exchange_weak(current, desired);
+    if constexpr (traceCounters)
+        tdata->cas.recordAttempt(ok, expected, current);
+    return ok;
+}
+
 bool get_work(thread_data *tdata)
 {
     auto allocate_tasks = [&](atomic<int> &counter, TaskType taskType) -> bool
     {
         int current = counter.load();
-        long long timestamp = duration_cast<nanoseconds>(high_resolution_clock::now().time_since_epoch()).count() - base_timestamp;
+        long long timestamp = traceTimestamp();
         if (current <= 0)
             return false;
         int allocated = min(taskInc, current);
         int retries = 0;
-        while (!counter.compare_exchange_weak(current, current - allocated))
+        long long casStart = chromeTraceNow();
+        while (!casClaim(tdata, counter, current, current - allocated))
         {
             if (++retries > MAX_CAS_RETRIES)
             {
+                if constexpr (traceCounters)
+                    tdata->cas.fallbacks++;
                 int old = counter.fetch_sub(taskInc);
                 allocated = min(taskInc, old);
                 current = old;
                 break;
             }
             if (sudokuInvalid.load())
+            {
+                // The claim was abandoned, but its time still shows in the trace
+                chromeTraceSpan(tdata->thread_id, "CAS", casStart, chromeTraceNow());
                 return false;
+            }
+            if constexpr (traceCounters)
+                tdata->cas.yields++;
             this_thread::yield();
         }
+        if constexpr (traceCounters)
+            tdata->cas.recordClaim(retries);
+        chromeTraceSpan(tdata->thread_id, "CAS", casStart, chromeTraceNow());
         tdata->currentTask = taskType;
         tdata->taskCount = allocated;
         tdata->startIndex = N - current;
-        string logMsg = "Thread " + to_string(tdata->thread_id) + " grabbed " + to_string(allocated) + " ";
-        logMsg += (taskType == ROW ? "row" : (taskType == COL ? "column" : "subgrid"));
-        logMsg += " tasks (counter updated) " + to_string(timestamp) + "\n";
-        Buffers[tdata->thread_id] += logMsg;
+        if constexpr (traceFull)
+        {
+            string logMsg = "Thread " + to_string(tdata->thread_id) + " grabbed " + to_string(allocated) + " ";
+            logMsg += (taskType == ROW ? "row" : (taskType == COL ? "column" : "subgrid"));
+            logMsg += " tasks (counter updated) " + to_string(timestamp) + "\n";
+            Buffers[tdata->thread_id] += logMsg;
+        }
         return true;
     };
 
@@ -218,21 +273,23 @@ bool do_work(thread_data *tdata)
         if (sudokuInvalid.load())
             return false;
         bool valid = false;
-        long long timestamp = duration_cast<nanoseconds>(high_resolution_clock::now().time_since_epoch()).count() - base_timestamp;
+        long long timestamp = traceTimestamp();
         if (tdata->currentTask == ROW)
         {
             valid = rowCheck(i);
             if (!valid)
             {
-                Buffers[tdata->thread_id] += "Thread " + to_string(tdata->thread_id) + " found error in row " +
-                                             to_string(i) + " " + to_string(timestamp) + "\n";
+                if constexpr (traceFull)
+                    Buffers[tdata->thread_id] += "Thread " + to_string(tdata->thread_id) + " found error in row " +
+                                                 to_string(i) + " " + to_string(timestamp) + "\n";
                 sudokuInvalid.store(true);
                 return false;
             }
             else
             {
-                Buffers[tdata->thread_id] += "Thread " + to_string(tdata->thread_id) + " validated row " +
-                                             to_string(i) + " " + to_string(timestamp) + "\n";
+                if constexpr (traceFull)
+                    Buffers[tdata->thread_id] += "Thread " + to_string(tdata->thread_id) + " validated row " +
+                                                 to_string(i) + " " + to_string(timestamp) + "\n";
             }
         }
         else if (tdata->currentTask == COL)
@@ -240,15 +297,17 @@ bool do_work(thread_data *tdata)
             valid = colCheck(i);
             if (!valid)
             {
-                Buffers[tdata->thread_id] += "Thread " + to_string(tdata->thread_id) + " found error in column " +
-                                             to_string(i) + " " + to_string(timestamp) + "\n";
+                if constexpr (traceFull)
+                    Buffers[tdata->thread_id] += "Thread " + to_string(tdata->thread_id) + " found error in column " +
+                                                 to_string(i) + " " + to_string(timestamp) + "\n";
                 sudokuInvalid.store(true);
                 return false;
             }
             else
             {
-                Buffers[tdata->thread_id] += "Thread " + to_string(tdata->thread_id) + " validated column " +
-                                             to_string(i) + " " + to_string(timestamp) + "\n";
+                if constexpr (traceFull)
+                    Buffers[tdata->thread_id] += "Thread " + to_string(tdata->thread_id) + " validated column " +
+                                                 to_string(i) + " " + to_string(timestamp) + "\n";
             }
         }
         else if (tdata->currentTask == SUB)
@@ -256,15 +315,17 @@ bool do_work(thread_data *tdata)
             valid = subCheck(i);
             if (!valid)
             {
-                Buffers[tdata->thread_id] += "Thread " + to_string(tdata->thread_id) + " found error in subgrid " +
-                                             to_string(i) + " " + to_string(timestamp) + "\n";
+                if constexpr (traceFull)
+                    Buffers[tdata->thread_id] += "Thread " + to_string(tdata->thread_id) + " found error in subgrid " +
+                                                 to_string(i) + " " + to_string(timestamp) + "\n";
                 sudokuInvalid.store(true);
                 return false;
             }
             else
             {
-                Buffers[tdata->thread_id] += "Thread " + to_string(tdata->thread_id) + " validated subgrid " +
-                                             to_string(i) + " " + to_string(timestamp) + "\n";
+                if constexpr (traceFull)
+                    Buffers[tdata->thread_id] += "Thread " + to_string(tdata->thread_id) + " validated subgrid " +
+                                                 to_string(i) + " " + to_string(timestamp) + "\n";
             }
         }
     }
@@ -274,29 +335,52 @@ bool do_work(thread_data *tdata)
 void *thdwork(void *param)
 {
     thread_data *tdata = (thread_data *)param;
+    PerfCounterGroup perf;
+    if constexpr (perfCountersEnabled)
+    {
+        if (perf.open())
+            perf.start();
+        else
+            tdata->perf_error = perf.error();
+    }
     while (true)
     {
         if (sudokuInvalid.load())
             break;
-        auto cs_entry = high_resolution_clock::now();
+        long long csEntryTime = 0, csExitTime = 0;
+        long long claimStart = chromeTraceNow();
+        if constexpr (traceCounters)
+            csEntryTime = timestampNow();
         bool hasWork = get_work(tdata);
-        auto cs_exit = high_resolution_clock::now();
-        long long csEntryTime = duration_cast<nanoseconds>(cs_entry.time_since_epoch()).count() - base_timestamp;
-        long long csExitTime = duration_cast<nanoseconds>(cs_exit.time_since_epoch()).count() - base_timestamp;
-        tdata->total_cs_entry_time += csEntryTime;
-        tdata->total_cs_exit_time += csExitTime;
-        if (csEntryTime > tdata->worst_cs_entry)
-            tdata->worst_cs_entry = csEntryTime;
-        if (csExitTime > tdata->worst_cs_exit)
-            tdata->worst_cs_exit = csExitTime;
-        tdata->cs_count++;
-        Buffers[tdata->thread_id] += "Thread " + to_string(tdata->thread_id) + " entered CS at " +
-                                     to_string(csEntryTime) + " and exited at " + to_string(csExitTime) + "\n";
+        chromeTraceSpan(tdata->thread_id, "get_work", claimStart, chromeTraceNow());
+        if constexpr (traceCounters)
+        {
+            csExitTime = timestampNow();
+            // Update per-thread timing statistics
+            tdata->total_cs_entry_time += csEntryTime;
+            tdata->total_cs_exit_time += csExitTime;
+            if (csEntryTime > tdata->worst_cs_entry)
+                tdata->worst_cs_entry = csEntryTime;
+            if (csExitTime > tdata->worst_cs_exit)
+                tdata->worst_cs_exit = csExitTime;
+            tdata->cs_count++;
+        }
+        if constexpr (traceFull)
+            Buffers[tdata->thread_id] += "Thread " + to_string(tdata->thread_id) + " entered CS at " +
+                                         to_string(csEntryTime) + " and exited at " + to_string(csExitTime) + "\n";
         if (!hasWork)
             break;
-        if (!do_work(tdata))
+        long long workStart = chromeTraceNow();
+        bool workOk = do_work(tdata);
+        chromeTraceSpan(tdata->thread_id, "work", workStart, chromeTraceNow());
+        if (!workOk)
             break;
     }
+    if constexpr (perfCountersEnabled)
+    {
+        tdata->perf = perf.stop();
+        perf.close();
+    }
     pthread_exit(NULL);
     return NULL;
 }
@@ -328,31 +412,35 @@ bool readInputFromFile(const string &filename)
     return true;
 }
 
-int main(int argc, char *argv[])
+// Runs one validation of the loaded sudoku with K threads and returns the
+// wall-clock time in nanoseconds. The per-thread statistics are left in
+// tdata_arr, which the caller owns. Shared with the in-process benchmark.
+long long runValidation(vector<thread_data *> &tdata_arr)
 {
-    if (!readInputFromFile(argv[1]))
-    {
-        return 1;
-    }
-    ofstream clearFile(output_filename, ios::out);
-    clearFile.close();
-
+    sudokuInvalid.store(false);
     task_rows.store(N);
     task_cols.store(N);
     task_subs.store(N);
 
-    Buffers.resize(K, "");
+    Buffers.assign(K, "");
 
     auto start_time = high_resolution_clock::now();
     base_timestamp = duration_cast<nanoseconds>(start_time.time_since_epoch()).count();
 
-    vector<thread_data *> tdata_arr;
+    tdata_arr.assign(K, nullptr);
     pthread_t threads[K];
     for (int i = 0; i < K; i++)
     {
-        tdata_arr.push_back(new thread_data());
+        tdata_arr[i] = new thread_data();
         tdata_arr[i]->thread_id = i;
     }
+    if constexpr (chromeTraceEnabled)
+    {
+        chromeTrace.init(K);
+        for (int i = 0; i < K; i++)
+            chromeTrace.nameThread(i, "Thread " + to_string(i));
+    }
+
     for (int i = 0; i < K; i++)
     {
         pthread_create(&threads[i], NULL, thdwork, (void *)tdata_arr[i]);
@@ -364,7 +452,25 @@ int main(int argc, char *argv[])
 
     auto end_time = high_resolution_clock::now();
     auto duration = duration_cast<nanoseconds>(end_time - start_time).count();
-    parseAndWriteLogs(Buffers);
+    if constexpr (chromeTraceEnabled)
+        chromeTrace.write("trace_BCAS.json");
+    return duration;
+}
+
+#ifndef ASSIGN2_NO_MAIN
+int main(int argc, char *argv[])
+{
+    if (!readInputFromFile(argv[1]))
+    {
+        return 1;
+    }
+    ofstream clearFile(output_filename, ios::out);
+    clearFile.close();
+
+    vector<thread_data *> tdata_arr;
+    long long duration = runValidation(tdata_arr);
+    if constexpr (traceFull)
+        parseAndWriteLogs(Buffers);
 
     string result = sudokuInvalid.load() ? "Sudoku is invalid.\n" : "Sudoku is valid.\n";
     writeOutputToFile(result);
@@ -372,6 +478,9 @@ int main(int argc, char *argv[])
     long long totalEntry = 0, totalExit = 0;
     long long worstEntry = 0, worstExit = 0;
     int totalCS = 0;
+    PerfSample perfTotal;
+    CasTelemetry casTotal;
+    string perfError;
     for (int i = 0; i < K; i++)
     {
         totalEntry += tdata_arr[i]->total_cs_entry_time;
@@ -381,6 +490,10 @@ int main(int argc, char *argv[])
         if (tdata_arr[i]->worst_cs_exit > worstExit)
             worstExit = tdata_arr[i]->worst_cs_exit;
         totalCS += tdata_arr[i]->cs_count;
+        perfTotal.add(tdata_arr[i]->perf);
+        casTotal.add(tdata_arr[i]->cas);
+        if (perfError.empty())
+            perfError = tdata_arr[i]->perf_error;
     }
     long long avgEntry = (totalCS > 0) ? totalEntry / totalCS : 0;
     long long avgExit = (totalCS > 0) ? totalExit / totalCS : 0;
@@ -388,16 +501,35 @@ int main(int argc, char *argv[])
 
 
     writeOutputToFile("The total time taken is " + to_string(duration) + " nanoseconds.\n");
-    writeOutputToFile("Average CS Entry Time is " + to_string(avgEntry) + " nanoseconds.\n");
-    writeOutputToFile("Average CS Exit Time is " + to_string(avgExit) + " nanoseconds.\n");
-    writeOutputToFile("Worst-case CS Entry Time is " + to_string(worstEntry) + " nanoseconds.\n");
-    writeOutputToFile("Worst-case CS Exit Time is " + to_string(worstExit) + " nanoseconds.\n");
+    if constexpr (traceCounters)
+    {
+        writeOutputToFile("Average CS Entry Time is " + to_string(avgEntry) + " nanoseconds.\n");
+        writeOutputToFile("Average CS Exit Time is " + to_string(avgExit) + " nanoseconds.\n");
+        writeOutputToFile("Worst-case CS Entry Time is " + to_string(worstEntry) + " nanoseconds.\n");
+        writeOutputToFile("Worst-case CS Exit Time is " + to_string(worstExit) + " nanoseconds.\n");
+    }
 
     cout << "The total time taken is " << duration << " nanoseconds." << endl;
-    cout << "Average CS Entry Time is " << avgEntry << " nanoseconds." << endl;
-    cout << "Average CS Exit Time is " << avgExit << " nanoseconds." << endl;
-    cout << "Worst-case CS Entry Time is " << worstEntry << " nanoseconds." << endl;
-    cout << "Worst-case CS Exit Time is " << worstExit << " nanoseconds." << endl;
+    if constexpr (traceCounters)
+    {
+        cout << "Average CS Entry Time is " << avgEntry << " nanoseconds." << endl;
+        cout << "Average CS Exit Time is " << avgExit << " nanoseconds." << endl;
+        cout << "Worst-case CS Entry Time is " << worstEntry << " nanoseconds." << endl;
+        cout << "Worst-case CS Exit Time is " << worstExit << " nanoseconds." << endl;
+        for (const string &line : casTotal.reportLines())
+        {
+            writeOutputToFile(line + "\n");
+            cout << line << endl;
+        }
+    }
+    if constexpr (perfCountersEnabled)
+    {
+        for (const string &line : perfReportLines(perfTotal, perfError))
+        {
+            writeOutputToFile(line + "\n");
+            cout << line << endl;
+        }
+    }
 
     for (int i = 0; i < K; i++)
     {
@@ -406,3 +538,4 @@ int main(int argc, char *argv[])
 
     return 0;
 }
+#endif
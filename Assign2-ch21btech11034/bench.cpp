@@ -0,0 +1,311 @@
+// In-process benchmark driver for the Assignment 2 dispensers.
+//
+// Replaces the process-per-data-point loop of exeperiments.py: the sudoku
+// grids are generated in memory, every strategy is linked into this binary
+// (each source is compiled into its own namespace with its main() disabled)
+// and each data point gets warm-up runs followed by repeated timed runs.
+// The results go to exp1/2/3_bench.csv with the <method>_total columns
+// plot.py reads (the median, in ms), followed by stddev and 95% CI columns;
+// python3 plot.py bench plots them. exeperiments.py keeps exp*_results.csv,
+// whose telemetry columns this build (TRACE_LEVEL 0) does not collect.
+//
+// Usage: ./assign2_bench [--iters=N] [--warmup=N] [--exp=123] [--seed=S] [--max-n=N] [--size=N]
+//   --max-n skips the larger sizes of experiment 1, --size sets the sudoku
+//   size of experiments 2 and 3 (default 8100, must be a perfect square).
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <pthread.h>
+#include <atomic>
+#include <algorithm>
+#include <thread>
+#include <random>
+#include <numeric>
+#include <functional>
+#include "chrome_trace.h"
+#include "perf_counters.h"
+#include "cas_telemetry.h"
+
+// Measure the dispensers without the per-event log unless asked otherwise
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL 0
+#endif
+
+#define ASSIGN2_NO_MAIN
+namespace tas
+{
+#include "assign2_TAS.cpp"
+}
+namespace cas
+{
+#include "assign2_CAS.cpp"
+}
+namespace bcas
+{
+#include "assign2_BoundedCAS.cpp"
+}
+namespace seq
+{
+#include "sequential.cpp"
+}
+
+using namespace std;
+using namespace std::chrono;
+
+typedef vector<vector<int>> Grid;
+
+// Same construction as generate_sudoku() in exeperiments.py
+Grid generateSudoku(int N, mt19937 &rng)
+{
+    int n = static_cast<int>(sqrt(N));
+    auto shuffled = [&](vector<int> v)
+    {
+        shuffle(v.begin(), v.end(), rng);
+        return v;
+    };
+    vector<int> groups(n), nums(N);
+    iota(groups.begin(), groups.end(), 0);
+    iota(nums.begin(), nums.end(), 1);
+    vector<int> rows, cols;
+    for (int g : shuffled(groups))
+    {
+        vector<int> band(n);
+        iota(band.begin(), band.end(), g * n);
+        for (int r : shuffled(band))
+            rows.push_back(r);
+    }
+    for (int g : shuffled(groups))
+    {
+        vector<int> stack(n);
+        iota(stack.begin(), stack.end(), g * n);
+        for (int c : shuffled(stack))
+            cols.push_back(c);
+    }
+    nums = shuffled(nums);
+    Grid grid(N, vector<int>(N));
+    for (int i = 0; i < N; i++)
+    {
+        for (int j = 0; j < N; j++)
+        {
+            int r = rows[i], c = cols[j];
+            grid[i][j] = nums[(n * (r % n) + r / n + c) % N];
+        }
+    }
+    return grid;
+}
+
+// One timed run of a strategy; returns nanoseconds
+typedef function<long long(Grid &, int, int)> Runner;
+
+template <typename Tdata>
+void freeThreadData(vector<Tdata *> &tdata_arr)
+{
+    for (Tdata *t : tdata_arr)
+        delete t;
+    tdata_arr.clear();
+}
+
+// The strategies read their own globals, so the grid is swapped in and out
+// instead of being copied for every run.
+#define STRATEGY_RUNNER(ns)                                     \
+    [](Grid &grid, int K, int taskInc) -> long long             \
+    {                                                           \
+        ns::K = K;                                              \
+        ns::N = grid.size();                                    \
+        ns::taskInc = min(taskInc, ns::N);                      \
+        ns::sudoku.swap(grid);                                  \
+        vector<ns::thread_data *> tdata_arr;                    \
+        long long duration = ns::runValidation(tdata_arr);      \
+        freeThreadData(tdata_arr);                              \
+        ns::sudoku.swap(grid);                                  \
+        return duration;                                        \
+    }
+
+long long runSequential(Grid &grid, int K, int taskInc)
+{
+    seq::K = K;
+    seq::N = grid.size();
+    seq::taskInc = taskInc;
+    seq::sudoku.swap(grid);
+    auto start_time = high_resolution_clock::now();
+    seq::sequentialRunner();
+    auto end_time = high_resolution_clock::now();
+    seq::sudoku.swap(grid);
+    return duration_cast<nanoseconds>(end_time - start_time).count();
+}
+
+struct Summary
+{
+    double median;
+    double stddev;
+    double ciLow;
+    double ciHigh;
+};
+
+// Two-sided 95% Student t critical values for 1..30 degrees of freedom
+double tCritical95(int dof)
+{
+    static const double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                   2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                   2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (dof < 1)
+        return 0;
+    return dof <= 30 ? table[dof - 1] : 1.960;
+}
+
+// Median, sample standard deviation and 95% confidence interval of the mean
+Summary summarize(vector<double> samples)
+{
+    Summary s{0, 0, 0, 0};
+    int n = samples.size();
+    if (n == 0)
+        return s;
+    sort(samples.begin(), samples.end());
+    s.median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+    double mean = accumulate(samples.begin(), samples.end(), 0.0) / n;
+    double sq = 0;
+    for (double x : samples)
+        sq += (x - mean) * (x - mean);
+    s.stddev = n > 1 ? sqrt(sq / (n - 1)) : 0;
+    double half = tCritical95(n - 1) * s.stddev / sqrt((double)n);
+    s.ciLow = mean - half;
+    s.ciHigh = mean + half;
+    return s;
+}
+
+int iterations = 10;
+int warmup = 2;
+
+// Warm-up runs are discarded; the timed runs are summarized in milliseconds
+Summary measure(const Runner &run, Grid &grid, int K, int taskInc)
+{
+    for (int i = 0; i < warmup; i++)
+        run(grid, K, taskInc);
+    vector<double> samples;
+    for (int i = 0; i < iterations; i++)
+        samples.push_back(run(grid, K, taskInc) / 1e6);
+    return summarize(samples);
+}
+
+vector<pair<string, Runner>> strategies = {
+    {"TAS", STRATEGY_RUNNER(tas)},
+    {"CAS", STRATEGY_RUNNER(cas)},
+    {"BoundedCAS", STRATEGY_RUNNER(bcas)},
+    {"Sequential", runSequential},
+};
+
+void writeCsvHeader(ofstream &out, const string &xName)
+{
+    out << xName;
+    for (const auto &s : strategies)
+        out << "," << s.first << "_total";
+    for (const auto &s : strategies)
+        out << "," << s.first << "_stddev," << s.first << "_ci95_low," << s.first << "_ci95_high";
+    out << "\n";
+}
+
+void writeCsvRow(ofstream &out, long long x, const vector<Summary> &row)
+{
+    out << x;
+    char buf[64];
+    for (const Summary &s : row)
+    {
+        snprintf(buf, sizeof(buf), ",%.2f", s.median);
+        out << buf;
+    }
+    for (const Summary &s : row)
+    {
+        snprintf(buf, sizeof(buf), ",%.3f,%.2f,%.2f", s.stddev, s.ciLow, s.ciHigh);
+        out << buf;
+    }
+    out << "\n";
+    out.flush();
+}
+
+// Runs every strategy at one data point and prints a progress line
+vector<Summary> runPoint(const string &label, Grid &grid, int K, int taskInc)
+{
+    vector<Summary> row;
+    for (const auto &s : strategies)
+    {
+        Summary sum = measure(s.second, grid, K, taskInc);
+        cout << label << " " << s.first << ": median " << sum.median << " ms, stddev " << sum.stddev
+             << " ms, 95% CI [" << sum.ciLow << ", " << sum.ciHigh << "]" << endl;
+        row.push_back(sum);
+    }
+    return row;
+}
+
+int main(int argc, char *argv[])
+{
+    string experiments = "123";
+    unsigned seed = 1;
+    int maxN = 10000;
+    int size = 8100;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        auto value = [&](const string &key) { return arg.substr(key.size()); };
+        if (arg.rfind("--iters=", 0) == 0)
+            iterations = stoi(value("--iters="));
+        else if (arg.rfind("--warmup=", 0) == 0)
+            warmup = stoi(value("--warmup="));
+        else if (arg.rfind("--exp=", 0) == 0)
+            experiments = value("--exp=");
+        else if (arg.rfind("--seed=", 0) == 0)
+            seed = stoul(value("--seed="));
+        else if (arg.rfind("--max-n=", 0) == 0)
+            maxN = stoi(value("--max-n="));
+        else if (arg.rfind("--size=", 0) == 0)
+            size = stoi(value("--size="));
+        else
+        {
+            cerr << "Usage: " << argv[0] << " [--iters=N] [--warmup=N] [--exp=123] [--seed=S] [--max-n=N] [--size=N]" << endl;
+            return 1;
+        }
+    }
+    if (iterations < 1)
+        iterations = 1;
+    int root = static_cast<int>(sqrt(size));
+    if (root * root != size)
+    {
+        cerr << "Error: N must be a perfect square." << endl;
+        return 1;
+    }
+    mt19937 rng(seed);
+
+    // Same grids as exeperiments.py
+    if (experiments.find('1') != string::npos)
+    {
+        ofstream out("exp1_bench.csv");
+        writeCsvHeader(out, "N");
+        for (int N : {400, 900, 1600, 2500, 3600, 4900, 6400, 8100, 10000})
+        {
+            if (N > maxN)
+                continue;
+            Grid grid = generateSudoku(N, rng);
+            writeCsvRow(out, N, runPoint("Exp 1 N=" + to_string(N), grid, 8, 20));
+        }
+    }
+    if (experiments.find('2') != string::npos)
+    {
+        ofstream out("exp2_bench.csv");
+        writeCsvHeader(out, "taskInc");
+        Grid grid = generateSudoku(size, rng);
+        for (int taskInc : {10, 20, 30, 40, 50})
+            writeCsvRow(out, taskInc, runPoint("Exp 2 taskInc=" + to_string(taskInc), grid, 8, taskInc));
+    }
+    if (experiments.find('3') != string::npos)
+    {
+        ofstream out("exp3_bench.csv");
+        writeCsvHeader(out, "Threads");
+        Grid grid = generateSudoku(size, rng);
+        for (int K : {1, 2, 4, 8, 16, 32})
+            writeCsvRow(out, K, runPoint("Exp 3 Threads=" + to_string(K), grid, K, 20));
+    }
+    return 0;
+}
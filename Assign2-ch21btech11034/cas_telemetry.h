@@ -0,0 +1,88 @@
+#ifndef CAS_TELEMETRY_H
+#define CAS_TELEMETRY_H
+
+// Per-thread compare_exchange statistics for the lock-free dispensers.
+// Every thread owns one instance, so the counters are plain integers; the
+// callers only touch them when TRACE_LEVEL includes counters.
+
+#include <string>
+#include <vector>
+
+// Retries per successful claim: bucket 0 is no retry, bucket b >= 1 holds
+// [2^(b-1), 2^b - 1] retries and the last bucket is open-ended.
+const int CAS_RETRY_BUCKETS = 16;
+
+struct CasTelemetry
+{
+    long long attempts = 0;
+    long long failures = 0;
+    long long spurious = 0; // failed although the counter still held the expected value
+    long long yields = 0;
+    long long fallbacks = 0; // claims that gave up on CAS and used fetch_sub
+    long long retryHistogram[CAS_RETRY_BUCKETS] = {};
+
+    void recordAttempt(bool ok, int expected, int observed)
+    {
+        attempts++;
+        if (!ok)
+        {
+            failures++;
+            if (observed == expected)
+                spurious++;
+        }
+    }
+
+    void recordClaim(int retries)
+    {
+        int bucket = 0;
+        while (retries > 0 && bucket < CAS_RETRY_BUCKETS - 1)
+        {
+            bucket++;
+            retries >>= 1;
+        }
+        retryHistogram[bucket]++;
+    }
+
+    void add(const CasTelemetry &other)
+    {
+        attempts += other.attempts;
+        failures += other.failures;
+        spurious += other.spurious;
+        yields += other.yields;
+        fallbacks += other.fallbacks;
+        for (int b = 0; b < CAS_RETRY_BUCKETS; b++)
+            retryHistogram[b] += other.retryHistogram[b];
+    }
+
+    // e.g. "0:812 1:40 2-3:7", empty buckets left out
+    std::string histogramString() const
+    {
+        std::string s;
+        for (int b = 0; b < CAS_RETRY_BUCKETS; b++)
+        {
+            if (retryHistogram[b] == 0)
+                continue;
+            long long lo = b == 0 ? 0 : 1LL << (b - 1);
+            long long hi = b == 0 ? 0 : (1LL << b) - 1;
+            std::string label = lo == hi ? std::to_string(lo) : std::to_string(lo) + "-" + std::to_string(hi);
+            if (b == CAS_RETRY_BUCKETS - 1)
+                label = std::to_string(lo) + "+";
+            s += (s.empty() ? "" : " ") + label + ":" + std::to_string(retryHistogram[b]);
+        }
+        return s;
+    }
+
+    std::vector<std::string> reportLines() const
+    {
+        return {
+            "CAS attempts: " + std::to_string(attempts),
+            "CAS failures: " + std::to_string(failures),
+            "CAS spurious failures: " + std::to_string(spurious),
+            "CAS yields: " + std::to_string(yields),
+            "CAS fallback fetch_subs: " + std::to_string(fallbacks),
+            "CAS retry histogram: " + histogramString(),
+        };
+    }
+};
+
+#endif
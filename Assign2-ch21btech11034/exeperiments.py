@@ -65,6 +65,15 @@ def write_input_file(filename, K, N, taskInc, sudoku):
 # ---------------------------
 # Experiment Runner Functions
 # ---------------------------
+# (metrics key, label after "CAS " in the program summary)
+CAS_TELEMETRY_FIELDS = [
+    ("cas_attempts", "attempts"),
+    ("cas_failures", "failures"),
+    ("cas_spurious", "spurious failures"),
+    ("cas_yields", "yields"),
+    ("cas_fallbacks", "fallback fetch_subs"),
+]
+
 def run_executable(executable, input_filename):
     """
     Run the given executable with the input file.
@@ -96,6 +105,12 @@ def run_executable(executable, input_filename):
         m_worst_exit = re.search(r"Worst-case CS Exit Time is\s*([\d\.]+)\s*nanoseconds", output, re.IGNORECASE)
         if m_worst_exit: metrics["worst_exit"] = float(m_worst_exit.group(1)) / 1_000_000
         else: metrics["worst_exit"] = None
+        # CAS telemetry (lock-free dispensers only)
+        for key, label in CAS_TELEMETRY_FIELDS:
+            m = re.search(rf"CAS {label}:\s*(\d+)", output)
+            if m: metrics[key] = float(m.group(1))
+        m_hist = re.search(r"CAS retry histogram:\s*(.*)", output)
+        if m_hist: metrics["cas_retry_hist"] = m_hist.group(1).strip()
         return metrics
     except subprocess.CalledProcessError as e:
         print("Error running executable:", e)
@@ -105,6 +120,8 @@ def average_metrics(dicts):
     """
     Given a list of metrics dictionaries, average each metric.
     Returns a dictionary with the averaged metrics.
+    CAS telemetry counters are averaged when present; the retry histogram
+    is kept from the last run.
     """
     avg = {"total_time":0, "avg_entry":0, "avg_exit":0, "worst_entry":0, "worst_exit":0}
     count = len(dicts)
@@ -114,6 +131,13 @@ def average_metrics(dicts):
                 avg[key] += d[key]
     for key in avg.keys():
         avg[key] = avg[key] / count if count > 0 else None
+    for key, _ in CAS_TELEMETRY_FIELDS:
+        values = [d[key] for d in dicts if key in d]
+        if values:
+            avg[key] = sum(values) / len(values)
+    hists = [d["cas_retry_hist"] for d in dicts if "cas_retry_hist" in d]
+    if hists:
+        avg["cas_retry_hist"] = hists[-1]
     return avg
 
 def average_over_runs(executable, input_filename, runs=5):
@@ -193,6 +217,34 @@ def save_tables_to_file(results, exp1_sizes, exp2_taskInc_values, exp3_thread_va
             f.write(row)
     print(f"Tables saved in {filename}")
 
+# ---------------------------
+# Function to Save CSVs (read by plot.py)
+# ---------------------------
+def save_results_csv(results, exp_key, x_name, x_values, filename):
+    """
+    Write one row per x-value with <method>_total columns (the layout plot.py
+    expects), followed by the CAS telemetry columns of the lock-free methods.
+    """
+    methods = list(results.keys())
+    cas_methods = [m for m in methods
+                   if any(v and "cas_attempts" in v for v in results[m][exp_key].values())]
+    header = [x_name] + [f"{m}_total" for m in methods]
+    for m in cas_methods:
+        header += [f"{m}_{key}" for key, _ in CAS_TELEMETRY_FIELDS] + [f"{m}_cas_retry_hist"]
+    with open(filename, "w") as f:
+        f.write(",".join(header) + "\n")
+        for x in x_values:
+            row = [str(x)]
+            for m in methods:
+                metrics = results[m][exp_key].get(x)
+                row.append(f"{metrics['total_time']:.2f}" if metrics else "")
+            for m in cas_methods:
+                metrics = results[m][exp_key].get(x) or {}
+                row += [f"{metrics[key]:.1f}" if key in metrics else "" for key, _ in CAS_TELEMETRY_FIELDS]
+                row.append(metrics.get("cas_retry_hist", ""))
+            f.write(",".join(row) + "\n")
+    print(f"Results saved in {filename}")
+
 # ---------------------------
 # Main Experiment Script
 # ---------------------------
@@ -279,6 +331,9 @@ def main():
     # Save Tables to File
     # ---------------------------
     save_tables_to_file(results, exp1_sizes, exp2_taskInc_values, exp3_thread_values)
+    save_results_csv(results, "exp1", "N", exp1_sizes, "exp1_results.csv")
+    save_results_csv(results, "exp2", "taskInc", exp2_taskInc_values, "exp2_results.csv")
+    save_results_csv(results, "exp3", "Threads", exp3_thread_values, "exp3_results.csv")
 
     # ---------------------------
     # Plotting the Results - Separate Files
@@ -0,0 +1,220 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+// Optional per-thread hardware counters through perf_event_open(2). Build
+// with -DPERF_COUNTERS to enable them. Each worker opens one counter group
+// for itself (cycles leads; instructions, L1D and LLC read misses follow).
+// Cache-line transfers have no portable event, so they are only counted
+// when PERF_HITM_EVENT holds a raw event code for this CPU, e.g.
+//   PERF_HITM_EVENT=0x04d2 ./assign2_TAS_perf input.txt   (Skylake xsnp_hitm)
+// Events the kernel or CPU refuses are skipped; if the leader cannot be
+// opened (no PMU, perf_event_paranoid, container) the run continues and
+// the summary says why the counters are missing.
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifdef PERF_COUNTERS
+constexpr bool perfCountersEnabled = true;
+#else
+constexpr bool perfCountersEnabled = false;
+#endif
+
+enum PerfEventId
+{
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_HITM,
+    PERF_EVENT_COUNT
+};
+
+const char *const perfEventNames[PERF_EVENT_COUNT] = {
+    "cycles", "instructions", "L1D read misses", "LLC read misses", "cache-line transfers (HITM)"};
+
+struct PerfSample
+{
+    bool valid = false;
+    bool present[PERF_EVENT_COUNT] = {};
+    unsigned long long values[PERF_EVENT_COUNT] = {};
+
+    void add(const PerfSample &other)
+    {
+        if (!other.valid)
+            return;
+        valid = true;
+        for (int e = 0; e < PERF_EVENT_COUNT; e++)
+        {
+            present[e] = present[e] || other.present[e];
+            values[e] += other.values[e];
+        }
+    }
+};
+
+class PerfCounterGroup
+{
+public:
+    PerfCounterGroup()
+    {
+        for (int e = 0; e < PERF_EVENT_COUNT; e++)
+            fds[e] = -1;
+    }
+
+    ~PerfCounterGroup()
+    {
+        close();
+    }
+
+    // Counts the calling thread on whatever CPU it runs on
+    bool open()
+    {
+        for (int e = 0; e < PERF_EVENT_COUNT; e++)
+        {
+            perf_event_attr attr;
+            if (!eventAttr(PerfEventId(e), attr))
+                continue;
+            int fd = syscall(SYS_perf_event_open, &attr, 0, -1, fds[PERF_CYCLES], 0);
+            if (fd < 0)
+            {
+                if (e == PERF_CYCLES)
+                {
+                    errorText = strerror(errno);
+                    return false;
+                }
+                continue;
+            }
+            fds[e] = fd;
+        }
+        return true;
+    }
+
+    void start()
+    {
+        if (fds[PERF_CYCLES] < 0)
+            return;
+        ioctl(fds[PERF_CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds[PERF_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    PerfSample stop()
+    {
+        PerfSample sample;
+        if (fds[PERF_CYCLES] < 0)
+            return sample;
+        ioctl(fds[PERF_CYCLES], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        // PERF_FORMAT_GROUP layout: nr, time_enabled, time_running, values in open order
+        unsigned long long data[3 + PERF_EVENT_COUNT];
+        if (read(fds[PERF_CYCLES], data, sizeof(data)) < (ssize_t)(3 * sizeof(unsigned long long)))
+            return sample;
+        unsigned long long enabled = data[1], running = data[2];
+        int slot = 0;
+        for (int e = 0; e < PERF_EVENT_COUNT && slot < (int)data[0]; e++)
+        {
+            if (fds[e] < 0)
+                continue;
+            unsigned long long value = data[3 + slot++];
+            // Scale up if the group was multiplexed off the PMU part of the time
+            if (running > 0 && running < enabled)
+                value = (unsigned long long)((double)value * enabled / running);
+            sample.present[e] = true;
+            sample.values[e] = value;
+        }
+        sample.valid = true;
+        return sample;
+    }
+
+    void close()
+    {
+        for (int e = 0; e < PERF_EVENT_COUNT; e++)
+        {
+            if (fds[e] >= 0)
+                ::close(fds[e]);
+            fds[e] = -1;
+        }
+    }
+
+    const std::string &error() const
+    {
+        return errorText;
+    }
+
+private:
+    static bool eventAttr(PerfEventId e, perf_event_attr &attr)
+    {
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        if (e == PERF_CYCLES)
+            attr.disabled = 1;
+        switch (e)
+        {
+        case PERF_CYCLES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            return true;
+        case PERF_INSTRUCTIONS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            return true;
+        case PERF_L1D_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            return true;
+        case PERF_LLC_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            return true;
+        case PERF_HITM:
+        {
+            const char *raw = getenv("PERF_HITM_EVENT");
+            if (raw == nullptr || *raw == '\0')
+                return false;
+            attr.type = PERF_TYPE_RAW;
+            attr.config = strtoull(raw, nullptr, 0);
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+    int fds[PERF_EVENT_COUNT];
+    std::string errorText;
+};
+
+// Summary lines for the totals of all threads, printed next to the timing lines
+inline std::vector<std::string> perfReportLines(const PerfSample &total, const std::string &error)
+{
+    std::vector<std::string> lines;
+    if (!total.valid)
+    {
+        lines.push_back("Perf counters unavailable: " + (error.empty() ? std::string("unknown error") : error));
+        return lines;
+    }
+    for (int e = 0; e < PERF_EVENT_COUNT; e++)
+    {
+        if (total.present[e])
+            lines.push_back(std::string("Perf ") + perfEventNames[e] + ": " + std::to_string(total.values[e]));
+        else if (e == PERF_HITM && getenv("PERF_HITM_EVENT") == nullptr)
+            lines.push_back(std::string("Perf ") + perfEventNames[e] + ": not configured (set PERF_HITM_EVENT)");
+        else
+            lines.push_back(std::string("Perf ") + perfEventNames[e] + ": not supported");
+    }
+    if (total.present[PERF_CYCLES] && total.present[PERF_INSTRUCTIONS] && total.values[PERF_CYCLES] > 0)
+        lines.push_back("Perf IPC: " + std::to_string((double)total.values[PERF_INSTRUCTIONS] / total.values[PERF_CYCLES]));
+    return lines;
+}
+
+#endif
@@ -1,4 +1,5 @@
 #!/usr/bin/env python3
+import sys
 import pandas as pd
 import matplotlib.pyplot as plt
 
@@ -52,9 +53,13 @@ def plot_exp3(csv_file, output_file):
     print(f"Saved plot: {output_file}")
 
 def main():
-    plot_exp1("exp1_results.csv", "exp1_plot.png")
-    plot_exp2("exp2_results.csv", "exp2_plot.png")
-    plot_exp3("exp3_results.csv", "exp3_plot.png")
+    # python3 plot.py bench plots exp*_bench.csv (assign2_bench) into
+    # exp*_bench_plot.png; the default is exeperiments.py's exp*_results.csv
+    tag = sys.argv[1] if len(sys.argv) > 1 else "results"
+    suffix = "" if tag == "results" else "_" + tag
+    plot_exp1(f"exp1_{tag}.csv", f"exp1{suffix}_plot.png")
+    plot_exp2(f"exp2_{tag}.csv", f"exp2{suffix}_plot.png")
+    plot_exp3(f"exp3_{tag}.csv", f"exp3{suffix}_plot.png")
 
 if __name__ == "__main__":
     main()
@@ -100,6 +100,7 @@ bool readInputFromFile(const string &filename)
     return true;
 }
 
+#ifndef ASSIGN2_NO_MAIN
 int main(int argc, char *argv[])
 {
     if (!readInputFromFile(argv[1]))
@@ -115,3 +116,4 @@ int main(int argc, char *argv[])
     cout << "The total time taken is " << totalDuration << " nanoseconds." << endl;
     return 0;
 }
+#endif
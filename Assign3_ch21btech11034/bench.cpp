@@ -0,0 +1,1000 @@
+// Throughput microbenchmarks for the Assignment 3 buffers.
+//
+// The producer-consumer programs sleep between items and log every
+// operation, so their run time says little about the buffer itself. Here the
+// threads move plain ints as fast as they can and the result is reported in
+// operations (items handed over) per second, the median of --iters runs.
+//
+// Usage: ./prod_cons-bench [--items=N] [--capacity=N] [--iters=N] [--max-threads=N]
+//                          [--sections=spsc,batch,payload,slab,scaling,multicast,overflow]
+//
+// spsc:  one producer and one consumer through the SPSC ring, compared with
+//        the semaphore scheme of prod_cons-sems (the general path, with sem_t
+//        and with the futex semaphores of -DFAST_SEM), the mutex + condition
+//        variable scheme and the MPMC ring.
+// batch: push_n/pop_n (--batch=B in both programs) with B = 1..256 on the
+//        semaphore and lock schemes and on BoundedBuffer's two-step batches
+//        with both policies, two producers and two consumers.
+// payload: BoundedBuffer<T, SyncPolicy> with 8 B, 256 B and 4 KB messages,
+//        copied in from a message the producer built first versus
+//        constructed in the slot with emplace; consumers always popInto.
+// slab:  256 B and 4 KB messages passed as pointers (new/delete) versus as
+//        slab pool handles through the MPMC ring, two producers and two
+//        consumers; reports ops/s and the peak RSS of the run.
+// scaling: 1 to --max-threads (default 64) producers and as many consumers on
+//        the semaphore and lock schemes, the MPMC ring and the sharded
+//        buffer with one shard per consumer, all with the same total capacity.
+// multicast: one producer, 1 to 4 consumer groups of one thread each, every
+//        group sees every item: the multicast ring (one copy of each item,
+//        one cursor per group) against pushing a copy into one MPMC ring per
+//        group. Reports items produced per second.
+// overflow: one producer offers items faster than two consumers take them,
+//        through BoundedBuffer<int, SyncPolicy> with each OverflowPolicy and
+//        with tryPush/tryEmplace and pushFor/emplaceFor; one consumer polls
+//        with tryPopInto, the other waits with popIntoFor. Reports items
+//        offered per second and the share shed, and checks that every item
+//        was either consumed once, in order, or counted as shed.
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <fstream>
+#include <cstring>
+#include <atomic>
+#include <semaphore.h>
+#include <pthread.h>
+#include "mpmc_ring.h"
+#include "spsc_ring.h"
+#include "bounded_buffer.h"
+#include "slab_pool.h"
+#include "sharded_buffer.h"
+#include "multicast_ring.h"
+#include "fast_semaphore.h"
+
+using namespace std;
+using namespace std::chrono;
+
+long long items = 1000000;
+int capacity = 100;
+int iterations = 5;
+int maxThreads = 64;
+string sections = "spsc,batch,payload,slab,scaling,multicast,overflow";
+
+// Same synchronization as ch21btech11034_assign3_semaphore.cpp; Sem is sem_t
+// or FastSemaphore (its sem_* overloads, as with -DFAST_SEM)
+template <typename Sem>
+struct SemBufferT
+{
+    vector<int> buffer;
+    int in_index = 0, out_index = 0;
+    Sem sem_empty, sem_full, sem_mutex;
+
+    explicit SemBufferT(int cap) : buffer(cap)
+    {
+        sem_init(&sem_empty, 0, cap);
+        sem_init(&sem_full, 0, 0);
+        sem_init(&sem_mutex, 0, 1);
+    }
+
+    ~SemBufferT()
+    {
+        sem_destroy(&sem_empty);
+        sem_destroy(&sem_full);
+        sem_destroy(&sem_mutex);
+    }
+
+    void push(int item)
+    {
+        sem_wait(&sem_empty);
+        sem_wait(&sem_mutex);
+        buffer[in_index] = item;
+        in_index = (in_index + 1) % buffer.size();
+        sem_post(&sem_mutex);
+        sem_post(&sem_full);
+    }
+
+    int pop()
+    {
+        sem_wait(&sem_full);
+        sem_wait(&sem_mutex);
+        int item = buffer[out_index];
+        out_index = (out_index + 1) % buffer.size();
+        sem_post(&sem_mutex);
+        sem_post(&sem_empty);
+        return item;
+    }
+
+    // Same claim as the program's push_n: one blocking sem_wait, sem_trywait
+    // for the rest, one pass through sem_mutex; returns how many went in
+    int pushN(const int *items, int n)
+    {
+        sem_wait(&sem_empty);
+        int k = 1;
+        while (k < n && sem_trywait(&sem_empty) == 0)
+            k++;
+        sem_wait(&sem_mutex);
+        for (int j = 0; j < k; j++)
+        {
+            buffer[in_index] = items[j];
+            in_index = (in_index + 1) % buffer.size();
+        }
+        sem_post(&sem_mutex);
+        for (int j = 0; j < k; j++)
+            sem_post(&sem_full);
+        return k;
+    }
+
+    int popN(int *items, int n)
+    {
+        sem_wait(&sem_full);
+        int k = 1;
+        while (k < n && sem_trywait(&sem_full) == 0)
+            k++;
+        sem_wait(&sem_mutex);
+        for (int j = 0; j < k; j++)
+        {
+            items[j] = buffer[out_index];
+            out_index = (out_index + 1) % buffer.size();
+        }
+        sem_post(&sem_mutex);
+        for (int j = 0; j < k; j++)
+            sem_post(&sem_empty);
+        return k;
+    }
+};
+
+typedef SemBufferT<sem_t> SemBuffer;
+typedef SemBufferT<FastSemaphore> FastSemBuffer;
+
+// Same synchronization as ch21btech11034_assign3_locks.cpp without the spin
+struct LockBuffer
+{
+    vector<int> buffer;
+    int in_index = 0, out_index = 0, count_items = 0;
+    pthread_mutex_t buffer_lock;
+    pthread_cond_t not_full, not_empty;
+
+    explicit LockBuffer(int cap) : buffer(cap)
+    {
+        pthread_mutex_init(&buffer_lock, NULL);
+        pthread_cond_init(&not_full, NULL);
+        pthread_cond_init(&not_empty, NULL);
+    }
+
+    ~LockBuffer()
+    {
+        pthread_mutex_destroy(&buffer_lock);
+        pthread_cond_destroy(&not_full);
+        pthread_cond_destroy(&not_empty);
+    }
+
+    void push(int item)
+    {
+        pthread_mutex_lock(&buffer_lock);
+        while (count_items == (int)buffer.size())
+            pthread_cond_wait(&not_full, &buffer_lock);
+        buffer[in_index] = item;
+        in_index = (in_index + 1) % buffer.size();
+        count_items++;
+        pthread_mutex_unlock(&buffer_lock);
+        pthread_cond_signal(&not_empty);
+    }
+
+    int pop()
+    {
+        pthread_mutex_lock(&buffer_lock);
+        while (count_items == 0)
+            pthread_cond_wait(&not_empty, &buffer_lock);
+        int item = buffer[out_index];
+        out_index = (out_index + 1) % buffer.size();
+        count_items--;
+        pthread_mutex_unlock(&buffer_lock);
+        pthread_cond_signal(&not_full);
+        return item;
+    }
+
+    int pushN(const int *items, int n)
+    {
+        pthread_mutex_lock(&buffer_lock);
+        while (count_items == (int)buffer.size())
+            pthread_cond_wait(&not_full, &buffer_lock);
+        int k = min(n, (int)buffer.size() - count_items);
+        for (int j = 0; j < k; j++)
+        {
+            buffer[in_index] = items[j];
+            in_index = (in_index + 1) % buffer.size();
+        }
+        count_items += k;
+        pthread_mutex_unlock(&buffer_lock);
+        if (k > 1)
+            pthread_cond_broadcast(&not_empty);
+        else
+            pthread_cond_signal(&not_empty);
+        return k;
+    }
+
+    int popN(int *items, int n)
+    {
+        pthread_mutex_lock(&buffer_lock);
+        while (count_items == 0)
+            pthread_cond_wait(&not_empty, &buffer_lock);
+        int k = min(n, count_items);
+        for (int j = 0; j < k; j++)
+        {
+            items[j] = buffer[out_index];
+            out_index = (out_index + 1) % buffer.size();
+        }
+        count_items -= k;
+        pthread_mutex_unlock(&buffer_lock);
+        if (k > 1)
+            pthread_cond_broadcast(&not_full);
+        else
+            pthread_cond_signal(&not_full);
+        return k;
+    }
+};
+
+// push_n/pop_n through BoundedBuffer's reservePush/PushBatch and
+// reservePop/PopBatch, which prod_cons-sems uses with SemaphoreSync
+template <typename Sync>
+struct BoundedBatchBuffer
+{
+    typedef BoundedBuffer<int, Sync> Buffer;
+    Buffer buf;
+
+    explicit BoundedBatchBuffer(int cap) : buf(cap)
+    {
+    }
+
+    int pushN(const int *items, int n)
+    {
+        size_t k = buf.reservePush(n);
+        typename Buffer::PushBatch batch(buf, k);
+        for (size_t j = 0; j < k; j++)
+            batch.emplace(items[j]);
+        return k;
+    }
+
+    int popN(int *items, int n)
+    {
+        size_t k = buf.reservePop(n);
+        typename Buffer::PopBatch batch(buf, k);
+        for (size_t j = 0; j < k; j++)
+            batch.popInto(items[j]);
+        return k;
+    }
+};
+
+// The rings never block; like the programs, spin by yielding while the
+// other side catches up
+template <typename Ring>
+struct RingBuffer
+{
+    Ring ring;
+
+    explicit RingBuffer(int cap) : ring(cap)
+    {
+    }
+
+    void push(int item)
+    {
+        size_t pos;
+        while (!ring.tryPush(item, pos))
+            this_thread::yield();
+    }
+
+    int pop()
+    {
+        size_t pos;
+        int item;
+        while (!ring.tryPop(item, pos))
+            this_thread::yield();
+        return item;
+    }
+};
+
+// Sharded buffer with one shard per consumer. Each producer thread keeps its
+// own random state and each consumer takes the next home shard the first time
+// it pops.
+struct ShardedRingBuffer
+{
+    ShardedBuffer<int> buf;
+    atomic<unsigned> nextHome{0};
+    atomic<unsigned> nextSeed{1};
+
+    ShardedRingBuffer(int cap, int shards) : buf(shards, cap)
+    {
+    }
+
+    void push(int item)
+    {
+        thread_local ShardedRingBuffer *owner = nullptr;
+        thread_local uint32_t rng;
+        if (owner != this)
+        {
+            owner = this;
+            rng = 2654435761u * nextSeed.fetch_add(1);
+        }
+        size_t shard;
+        while (!buf.tryPush(item, rng, shard))
+            this_thread::yield();
+    }
+
+    int pop()
+    {
+        thread_local ShardedRingBuffer *owner = nullptr;
+        thread_local size_t home;
+        if (owner != this)
+        {
+            owner = this;
+            home = nextHome.fetch_add(1);
+        }
+        size_t shard;
+        int item;
+        while (!buf.tryPop(item, home, shard))
+            this_thread::yield();
+        return item;
+    }
+};
+
+// One producer and one consumer hand over items; returns operations per second
+template <typename Buffer>
+double runOnePair()
+{
+    Buffer buf(capacity);
+    long long checksum = 0;
+    auto start_time = steady_clock::now();
+    thread producer([&]()
+                    {
+                        for (long long i = 0; i < items; i++)
+                            buf.push(static_cast<int>(i));
+                    });
+    thread consumer([&]()
+                    {
+                        for (long long i = 0; i < items; i++)
+                            checksum += buf.pop();
+                    });
+    producer.join();
+    consumer.join();
+    double seconds = duration<double>(steady_clock::now() - start_time).count();
+    long long expected = (items - 1) * items / 2;
+    if (checksum != expected)
+        cerr << "Warning: checksum mismatch" << endl;
+    return items / seconds;
+}
+
+// Two producers and two consumers move items in batches of up to batch
+template <typename Buffer>
+double runBatched(int cap, int batch)
+{
+    const int threads = 2;
+    Buffer buf(cap);
+    long long perThread = items / threads;
+    vector<long long> checksums(threads, 0);
+    auto start_time = steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]()
+                             {
+                                 vector<int> burst(batch);
+                                 for (long long i = 0; i < perThread;)
+                                 {
+                                     int n = min<long long>(batch, perThread - i);
+                                     for (int j = 0; j < n; j++)
+                                         burst[j] = static_cast<int>(i + j);
+                                     int done = 0;
+                                     while (done < n)
+                                         done += buf.pushN(burst.data() + done, n - done);
+                                     i += n;
+                                 }
+                             });
+        workers.emplace_back([&, t]()
+                             {
+                                 vector<int> out(batch);
+                                 for (long long i = 0; i < perThread;)
+                                 {
+                                     int k = buf.popN(out.data(), min<long long>(batch, perThread - i));
+                                     for (int j = 0; j < k; j++)
+                                         checksums[t] += out[j];
+                                     i += k;
+                                 }
+                             });
+    }
+    for (thread &w : workers)
+        w.join();
+    double seconds = duration<double>(steady_clock::now() - start_time).count();
+    long long checksum = 0;
+    for (long long c : checksums)
+        checksum += c;
+    if (checksum != threads * ((perThread - 1) * perThread / 2))
+        cerr << "Warning: checksum mismatch" << endl;
+    return threads * perThread / seconds;
+}
+
+// n producers and n consumers share one Buffer(args...); returns ops/s
+template <typename Buffer, typename... Args>
+double runScaling(int n, Args... args)
+{
+    Buffer buf(args...);
+    long long perThread = items / n;
+    vector<long long> checksums(n, 0);
+    auto start_time = steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < n; t++)
+    {
+        workers.emplace_back([&]()
+                             {
+                                 for (long long i = 0; i < perThread; i++)
+                                     buf.push(static_cast<int>(i));
+                             });
+        workers.emplace_back([&, t]()
+                             {
+                                 for (long long i = 0; i < perThread; i++)
+                                     checksums[t] += buf.pop();
+                             });
+    }
+    for (thread &w : workers)
+        w.join();
+    double seconds = duration<double>(steady_clock::now() - start_time).count();
+    long long checksum = 0;
+    for (long long c : checksums)
+        checksum += c;
+    if (checksum != n * ((perThread - 1) * perThread / 2))
+        cerr << "Warning: checksum mismatch" << endl;
+    return n * perThread / seconds;
+}
+
+// One producer and one consumer per group; every group must see every item.
+// With multicast the groups share one MulticastRing, otherwise the producer
+// pushes a copy of each item into one MpmcRing per group.
+template <bool multicast>
+double runFanOut(int groups)
+{
+    MulticastRing<int> shared(capacity, groups);
+    vector<unique_ptr<MpmcRing<int>>> copies;
+    if constexpr (!multicast)
+        for (int g = 0; g < groups; g++)
+            copies.emplace_back(new MpmcRing<int>(capacity));
+    vector<long long> checksums(groups, 0);
+    auto start_time = steady_clock::now();
+    vector<thread> workers;
+    workers.emplace_back([&]()
+                         {
+                             size_t pos;
+                             for (long long i = 0; i < items; i++)
+                             {
+                                 if constexpr (multicast)
+                                 {
+                                     while (!shared.tryPush(static_cast<int>(i), pos))
+                                         this_thread::yield();
+                                 }
+                                 else
+                                 {
+                                     for (auto &ring : copies)
+                                         while (!ring->tryPush(static_cast<int>(i), pos))
+                                             this_thread::yield();
+                                 }
+                             }
+                         });
+    for (int g = 0; g < groups; g++)
+    {
+        workers.emplace_back([&, g]()
+                             {
+                                 long long seen = 0;
+                                 while (seen < items)
+                                 {
+                                     size_t n;
+                                     if constexpr (multicast)
+                                         n = shared.consume(g, 64, [&](int item, unsigned long long)
+                                                            { checksums[g] += item; });
+                                     else
+                                     {
+                                         size_t pos;
+                                         int item;
+                                         n = copies[g]->tryPop(item, pos) ? 1 : 0;
+                                         if (n)
+                                             checksums[g] += item;
+                                     }
+                                     if (n == 0)
+                                         this_thread::yield();
+                                     seen += n;
+                                 }
+                             });
+    }
+    for (thread &w : workers)
+        w.join();
+    double seconds = duration<double>(steady_clock::now() - start_time).count();
+    for (long long c : checksums)
+        if (c != (items - 1) * items / 2)
+            cerr << "Warning: checksum mismatch" << endl;
+    return items / seconds;
+}
+
+// Fixed-size message; the constructor fills the whole body like a producer
+// assembling a real message would
+template <int Size>
+struct Message
+{
+    int seed;
+    unsigned char body[Size - sizeof(int)];
+
+    Message() = default;
+
+    explicit Message(int seed) : seed(seed)
+    {
+        for (size_t j = 0; j < sizeof(body); j++)
+            body[j] = static_cast<unsigned char>(seed + j);
+    }
+
+    unsigned char last() const
+    {
+        return body[sizeof(body) - 1];
+    }
+};
+
+// Move-only message whose body lives on the heap
+template <int Size>
+struct HeapMessage
+{
+    int seed = 0;
+    unique_ptr<unsigned char[]> body;
+
+    HeapMessage() = default;
+
+    explicit HeapMessage(int seed) : seed(seed), body(new unsigned char[Size])
+    {
+        for (int j = 0; j < Size; j++)
+            body[j] = static_cast<unsigned char>(seed + j);
+    }
+
+    unsigned char last() const
+    {
+        return body[Size - 1];
+    }
+};
+
+// Consumers store the end of every body here so the copy cannot be elided;
+// several consumers store at once, hence an atomic (relaxed, as only the
+// store matters)
+atomic<unsigned char> lastSeen;
+
+// One producer and one consumer pass Msg through BoundedBuffer<Msg, Sync>;
+// inPlace builds each message in its slot, otherwise it is built and copied in
+template <typename Msg, typename Sync, bool inPlace>
+double runPayload()
+{
+    BoundedBuffer<Msg, Sync> buf(capacity);
+    long long checksum = 0;
+    auto start_time = steady_clock::now();
+    thread producer([&]()
+                    {
+                        for (long long i = 0; i < items; i++)
+                        {
+                            if constexpr (inPlace)
+                                buf.emplace(static_cast<int>(i));
+                            else
+                            {
+                                Msg msg(static_cast<int>(i));
+                                buf.emplace(msg);
+                            }
+                        }
+                    });
+    thread consumer([&]()
+                    {
+                        Msg out;
+                        for (long long i = 0; i < items; i++)
+                        {
+                            buf.popInto(out);
+                            checksum += out.seed;
+                            lastSeen.store(out.last(), memory_order_relaxed);
+                        }
+                    });
+    producer.join();
+    consumer.join();
+    double seconds = duration<double>(steady_clock::now() - start_time).count();
+    if (checksum != (items - 1) * items / 2)
+        cerr << "Warning: checksum mismatch" << endl;
+    return items / seconds;
+}
+
+// Resets the peak RSS so VmHWM covers only what follows (Linux >= 4.0)
+void resetPeakRss()
+{
+    ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+}
+
+// VmHWM (peak resident set) from /proc/self/status in kB, 0 if unavailable
+long long peakRssKb()
+{
+    ifstream status("/proc/self/status");
+    string key;
+    long long value;
+    while (status >> key)
+    {
+        if (key == "VmHWM:" && status >> value)
+            return value;
+        status.ignore(256, '\n');
+    }
+    return 0;
+}
+
+long long lastPeakRss = 0;
+
+// Two producers and two consumers move Size-byte messages through the MPMC
+// ring: as new'ed pointers deleted by the consumer, or as slab handles
+template <int Size, bool useSlabs>
+double runSlab()
+{
+    const int threads = 2;
+    const size_t cacheSize = 64;
+    typedef typename conditional<useSlabs, SlabHandle, Message<Size> *>::type Ref;
+    MpmcRing<Ref> ring(capacity);
+    // Enough slabs for a full ring and full caches on every thread
+    unique_ptr<SlabPool> pool;
+    if constexpr (useSlabs)
+        pool.reset(new SlabPool(sizeof(Message<Size>), capacity + 2 * threads * cacheSize + threads));
+    long long perThread = items / threads;
+    vector<long long> checksums(threads, 0);
+    resetPeakRss();
+    auto start_time = steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&]()
+                             {
+                                 unique_ptr<SlabPool::Cache> cache;
+                                 if constexpr (useSlabs)
+                                     cache.reset(new SlabPool::Cache(*pool, cacheSize));
+                                 size_t pos;
+                                 for (long long i = 0; i < perThread; i++)
+                                 {
+                                     Ref ref;
+                                     if constexpr (useSlabs)
+                                     {
+                                         // The producer fills the slab in place
+                                         while (!cache->tryAllocate(ref))
+                                             this_thread::yield();
+                                         new (cache->data(ref)) Message<Size>(static_cast<int>(i));
+                                     }
+                                     else
+                                         ref = new Message<Size>(static_cast<int>(i));
+                                     while (!ring.tryPush(ref, pos))
+                                         this_thread::yield();
+                                 }
+                             });
+        workers.emplace_back([&, t]()
+                             {
+                                 unique_ptr<SlabPool::Cache> cache;
+                                 if constexpr (useSlabs)
+                                     cache.reset(new SlabPool::Cache(*pool, cacheSize));
+                                 size_t pos;
+                                 for (long long i = 0; i < perThread; i++)
+                                 {
+                                     Ref ref;
+                                     while (!ring.tryPop(ref, pos))
+                                         this_thread::yield();
+                                     if constexpr (useSlabs)
+                                     {
+                                         Message<Size> *m = static_cast<Message<Size> *>(cache->data(ref));
+                                         checksums[t] += m->seed;
+                                         lastSeen.store(m->last(), memory_order_relaxed);
+                                         cache->release(ref);
+                                     }
+                                     else
+                                     {
+                                         checksums[t] += ref->seed;
+                                         lastSeen.store(ref->last(), memory_order_relaxed);
+                                         delete ref;
+                                     }
+                                 }
+                             });
+    }
+    for (thread &w : workers)
+        w.join();
+    double seconds = duration<double>(steady_clock::now() - start_time).count();
+    lastPeakRss = peakRssKb();
+    long long checksum = 0;
+    for (long long c : checksums)
+        checksum += c;
+    if (checksum != threads * ((perThread - 1) * perThread / 2))
+        cerr << "Warning: checksum mismatch" << endl;
+    return threads * perThread / seconds;
+}
+
+// How the producer of runOverflow hands over its items
+enum class OfferMode
+{
+    Offer,   // offer() with the buffer's overflow policy
+    TryPush, // tryPush and tryEmplace by turns
+    PushFor  // pushFor and emplaceFor by turns, with a 10 us timeout
+};
+
+double lastShedPercent = 0;
+
+// One producer offers items to two consumers that do some work on each, so
+// the buffer runs full and the overflow policy (or the timeout) decides
+template <typename Sync>
+double runOverflow(OverflowPolicy policy, OfferMode mode)
+{
+    BoundedBuffer<int, Sync> buf(capacity, policy);
+    atomic<bool> done{false};
+    long long refused = 0, dropped = 0;
+    vector<vector<int>> seen(2);
+    auto start_time = steady_clock::now();
+    thread producer([&]()
+                    {
+                        for (long long i = 0; i < items; i++)
+                        {
+                            int item = static_cast<int>(i);
+                            bool in = true;
+                            if (mode == OfferMode::Offer)
+                            {
+                                PushResult r = buf.offer(item);
+                                if (r == PushResult::Rejected)
+                                    refused++;
+                                else if (r != PushResult::Pushed)
+                                    dropped++;
+                            }
+                            else if (mode == OfferMode::TryPush)
+                                in = i % 2 ? buf.tryPush(move(item)) : buf.tryEmplace(item);
+                            else
+                                in = i % 2 ? buf.pushFor(microseconds(10), move(item)) : buf.emplaceFor(microseconds(10), item);
+                            if (!in)
+                                refused++;
+                        }
+                        done.store(true, memory_order_release);
+                    });
+    vector<thread> consumers;
+    for (int c = 0; c < 2; c++)
+    {
+        consumers.emplace_back([&, c]()
+                               {
+                                   int item;
+                                   for (;;)
+                                   {
+                                       bool got = c == 0 ? buf.tryPopInto(item) : buf.popIntoFor(milliseconds(1), item);
+                                       if (!got)
+                                       {
+                                           // Everything pushed is in the buffer once done is set
+                                           if (done.load(memory_order_acquire))
+                                           {
+                                               if (!buf.tryPopInto(item))
+                                                   break;
+                                           }
+                                           else
+                                           {
+                                               this_thread::yield();
+                                               continue;
+                                           }
+                                       }
+                                       seen[c].push_back(item);
+                                       unsigned h = item;
+                                       for (int w = 0; w < 64; w++)
+                                           h = h * 2654435761u + 1;
+                                       lastSeen.store(static_cast<unsigned char>(h), memory_order_relaxed);
+                                   }
+                               });
+    }
+    producer.join();
+    for (thread &c : consumers)
+        c.join();
+    double seconds = duration<double>(steady_clock::now() - start_time).count();
+
+    // With one producer the buffer is in id order, so each consumer must see
+    // increasing ids, and no id may turn up twice
+    vector<int> all;
+    bool ordered = true;
+    for (const vector<int> &ids : seen)
+    {
+        ordered = ordered && is_sorted(ids.begin(), ids.end());
+        all.insert(all.end(), ids.begin(), ids.end());
+    }
+    sort(all.begin(), all.end());
+    bool unique = adjacent_find(all.begin(), all.end()) == all.end();
+    if (!ordered || !unique || static_cast<long long>(all.size()) != items - refused - dropped)
+        cerr << "Warning: items lost, duplicated or out of order" << endl;
+    lastShedPercent = 100.0 * (refused + dropped) / items;
+    return items / seconds;
+}
+
+double median(vector<double> samples)
+{
+    sort(samples.begin(), samples.end());
+    int n = samples.size();
+    return n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+}
+
+// Median ops/s of the timed runs after one warm-up run
+double measure(const function<double()> &run)
+{
+    run();
+    vector<double> samples;
+    for (int i = 0; i < iterations; i++)
+        samples.push_back(run());
+    return median(samples);
+}
+
+void report(const string &name, const function<double()> &run)
+{
+    printf("  %-32s %14.0f ops/s\n", name.c_str(), measure(run));
+}
+
+void benchSpsc()
+{
+    cout << "np = nc = 1, capacity " << capacity << ", " << items << " items, median of " << iterations << " runs" << endl;
+    report("SPSC ring", runOnePair<RingBuffer<SpscRing<int>>>);
+    report("Semaphores (general path)", runOnePair<SemBuffer>);
+    report("Futex semaphores (FAST_SEM)", runOnePair<FastSemBuffer>);
+    report("Mutex + condition variables", runOnePair<LockBuffer>);
+    report("MPMC ring", runOnePair<RingBuffer<MpmcRing<int>>>);
+}
+
+void benchBatch()
+{
+    // Room for the largest batch, otherwise B is capped by the free slots
+    int cap = max(capacity, 512);
+    cout << "np = nc = 2, capacity " << cap << ", " << items << " items, median of " << iterations << " runs" << endl;
+    for (int batch = 1; batch <= 256; batch *= 2)
+    {
+        report("Semaphores, B = " + to_string(batch), [&]()
+               { return runBatched<SemBuffer>(cap, batch); });
+        report("Futex semaphores, B = " + to_string(batch), [&]()
+               { return runBatched<FastSemBuffer>(cap, batch); });
+        report("Mutex + cond vars, B = " + to_string(batch), [&]()
+               { return runBatched<LockBuffer>(cap, batch); });
+        report("BoundedBuffer sems, B = " + to_string(batch), [&]()
+               { return runBatched<BoundedBatchBuffer<SemaphoreSync>>(cap, batch); });
+        report("BoundedBuffer mutex, B = " + to_string(batch), [&]()
+               { return runBatched<BoundedBatchBuffer<MutexSync>>(cap, batch); });
+    }
+}
+
+template <typename Sync>
+void benchPayloadPolicy(const string &policy)
+{
+    report(policy + " 8 B copy", runPayload<Message<8>, Sync, false>);
+    report(policy + " 8 B emplace", runPayload<Message<8>, Sync, true>);
+    report(policy + " 256 B copy", runPayload<Message<256>, Sync, false>);
+    report(policy + " 256 B emplace", runPayload<Message<256>, Sync, true>);
+    report(policy + " 4 KB copy", runPayload<Message<4096>, Sync, false>);
+    report(policy + " 4 KB emplace", runPayload<Message<4096>, Sync, true>);
+    report(policy + " 4 KB heap, move-only", runPayload<HeapMessage<4096>, Sync, true>);
+}
+
+void benchPayload()
+{
+    cout << "np = nc = 1, capacity " << capacity << ", " << items << " items, median of " << iterations << " runs" << endl;
+    benchPayloadPolicy<SemaphoreSync>("Semaphores");
+    benchPayloadPolicy<MutexSync>("Mutex");
+}
+
+void benchSlab()
+{
+    cout << "np = nc = 2, MPMC ring capacity " << capacity << ", " << items << " items, median of " << iterations << " runs" << endl;
+    auto withRss = [](const string &name, double (*run)())
+    {
+        double opsPerSec = measure(run);
+        printf("  %-32s %14.0f ops/s %10lld kB peak RSS\n", name.c_str(), opsPerSec, lastPeakRss);
+    };
+    withRss("256 B new/delete", runSlab<256, false>);
+    withRss("256 B slab pool", runSlab<256, true>);
+    withRss("4 KB new/delete", runSlab<4096, false>);
+    withRss("4 KB slab pool", runSlab<4096, true>);
+}
+
+void benchScaling()
+{
+    cout << "np = nc = 1.." << maxThreads << ", total capacity " << capacity << ", " << items << " items, median of "
+         << iterations << " runs" << endl;
+    for (int n = 1; n <= maxThreads; n *= 2)
+    {
+        string suffix = ", " + to_string(n) + " + " + to_string(n);
+        report("Semaphores" + suffix, [&]()
+               { return runScaling<SemBuffer>(n, capacity); });
+        report("Mutex + cond vars" + suffix, [&]()
+               { return runScaling<LockBuffer>(n, capacity); });
+        report("MPMC ring" + suffix, [&]()
+               { return runScaling<RingBuffer<MpmcRing<int>>>(n, capacity); });
+        report("Sharded, " + to_string(n) + " shards" + suffix, [&]()
+               { return runScaling<ShardedRingBuffer>(n, capacity, n); });
+        // Only differs from capacity with fewer than two slots per shard
+        size_t shardedCapacity = ShardedBuffer<int>(n, capacity).capacity();
+        if (shardedCapacity != static_cast<size_t>(capacity))
+            cout << "    (the sharded buffer has " << shardedCapacity << " slots, two per shard at least)" << endl;
+    }
+}
+
+void benchMulticast()
+{
+    cout << "np = 1, one consumer per group, capacity " << capacity << ", " << items << " items, median of "
+         << iterations << " runs (items produced per second)" << endl;
+    for (int groups = 1; groups <= 4; groups++)
+    {
+        string suffix = to_string(groups) + (groups == 1 ? " group" : " groups");
+        report("Multicast ring, " + suffix, [&]()
+               { return runFanOut<true>(groups); });
+        report("MPMC ring per group, " + suffix, [&]()
+               { return runFanOut<false>(groups); });
+    }
+}
+
+template <typename Sync>
+void benchOverflowPolicy(const string &name)
+{
+    auto withShed = [](const string &label, const function<double()> &run)
+    {
+        double opsPerSec = measure(run);
+        printf("  %-32s %14.0f ops/s %8.1f%% shed\n", label.c_str(), opsPerSec, lastShedPercent);
+    };
+    const pair<const char *, OverflowPolicy> policies[] = {
+        {"block", OverflowPolicy::Block},
+        {"reject", OverflowPolicy::Reject},
+        {"drop-oldest", OverflowPolicy::DropOldest},
+        {"drop-newest", OverflowPolicy::DropNewest},
+    };
+    for (const auto &p : policies)
+        withShed(name + ", offer " + p.first, [&]()
+                 { return runOverflow<Sync>(p.second, OfferMode::Offer); });
+    withShed(name + ", tryPush", []()
+             { return runOverflow<Sync>(OverflowPolicy::Block, OfferMode::TryPush); });
+    withShed(name + ", pushFor 10 us", []()
+             { return runOverflow<Sync>(OverflowPolicy::Block, OfferMode::PushFor); });
+}
+
+void benchOverflow()
+{
+    cout << "np = 1, nc = 2, capacity " << capacity << ", " << items << " items offered, median of " << iterations
+         << " runs" << endl;
+    benchOverflowPolicy<SemaphoreSync>("Semaphores");
+    benchOverflowPolicy<MutexSync>("Mutex");
+}
+
+int main(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg.rfind("--items=", 0) == 0)
+            items = stoll(arg.substr(8));
+        else if (arg.rfind("--capacity=", 0) == 0)
+            capacity = stoi(arg.substr(11));
+        else if (arg.rfind("--iters=", 0) == 0)
+            iterations = max(1, stoi(arg.substr(8)));
+        else if (arg.rfind("--max-threads=", 0) == 0)
+            maxThreads = max(1, stoi(arg.substr(14)));
+        else if (arg.rfind("--sections=", 0) == 0)
+            sections = arg.substr(11);
+        else
+        {
+            cerr << "Usage: " << argv[0] << " [--items=N] [--capacity=N] [--iters=N] [--max-threads=N] [--sections=spsc,batch,payload,slab,scaling,multicast,overflow]" << endl;
+            return 1;
+        }
+    }
+    if (items < 1 || capacity < 1)
+    {
+        cerr << "Error: items and capacity must be positive" << endl;
+        return 1;
+    }
+    if (sections.find("spsc") != string::npos)
+        benchSpsc();
+    if (sections.find("batch") != string::npos)
+        benchBatch();
+    if (sections.find("payload") != string::npos)
+        benchPayload();
+    if (sections.find("slab") != string::npos)
+        benchSlab();
+    if (sections.find("scaling") != string::npos)
+        benchScaling();
+    if (sections.find("multicast") != string::npos)
+        benchMulticast();
+    if (sections.find("overflow") != string::npos)
+        benchOverflow();
+    return 0;
+}
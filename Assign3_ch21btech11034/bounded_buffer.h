@@ -0,0 +1,797 @@
+#ifndef BOUNDED_BUFFER_H
+#define BOUNDED_BUFFER_H
+
+// Reusable bounded buffer for any T, including move-only types. Items are
+// constructed straight into their slot (emplace) and moved out into storage
+// the caller owns (popInto), so a large message is never copied through a
+// temporary. How producers and consumers wait for each other is a policy:
+//
+//   SemaphoreSync  the scheme of prod_cons-sems: empty/full counting
+//                  semaphores plus a binary semaphore as the mutex;
+//                  BasicSemaphoreSync<Sem> takes any semaphore type with
+//                  sem_* overloads, such as FastSemaphore (fast_semaphore.h)
+//   MutexSync      the scheme of prod_cons-locks: one mutex with not_full
+//                  and not_empty condition variables
+//
+// A policy provides beginPush/commitPush/abortPush and beginPop/commitPop.
+// beginPush returns once a slot is free and the caller holds exclusive access
+// to the push side; commitPush publishes the item and abortPush gives the slot
+// back (used when T's constructor throws). The pop side is the same without
+// an abort, since moving out of a slot must not throw. tryBeginPush and
+// beginPushUntil (and their pop twins) do the same but return false instead
+// of waiting, or once a CLOCK_MONOTONIC deadline has passed.
+// beginExclusive/endExclusive give exclusive access to the whole buffer
+// without claiming a slot or an item.
+//
+// Batches are claimed in two steps, so the wait for room (or items) can be
+// timed and logged apart from the critical section, as prod_cons-sems does:
+//
+//   typedef BoundedBuffer<Item, SemaphoreSync> Buffer;
+//   size_t k = buffer.reservePush(n);        // waits for one slot, claims up to n
+//   {
+//       Buffer::PushBatch batch(buffer, k);  // takes the push side
+//       size_t pos = batch.emplace(args...); // at most k times
+//   }                                        // publishes them, frees the rest
+//
+// PopBatch is the same for the pop side; tryReservePop claims items without
+// waiting and unreservePop gives one back. For these a policy provides
+// reservePush/beginReservedPush/finishPush and their pop twins; a claim is a
+// semaphore token in SemaphoreSync and a counter under the mutex in MutexSync.
+//
+// Besides blocking, a buffer can be given an OverflowPolicy that offer()
+// applies when it is full: refuse the new item (Reject), or make room for
+// it by destroying the oldest item (DropOldest) or the newest one, the item
+// that went in last (DropNewest).
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <pthread.h>
+#include <semaphore.h>
+
+enum class OverflowPolicy
+{
+    Block,
+    Reject,
+    DropOldest,
+    DropNewest
+};
+
+// What offer() did with an item
+enum class PushResult
+{
+    Pushed,
+    Rejected,
+    DroppedNewest, // the new item took the place of the newest buffered one
+    DroppedOldest  // the new item went in, the oldest one was discarded
+};
+
+// Parses block, reject, drop-oldest or drop-newest
+inline bool parseOverflowPolicy(const std::string &spec, OverflowPolicy &out)
+{
+    if (spec == "block")
+        out = OverflowPolicy::Block;
+    else if (spec == "reject")
+        out = OverflowPolicy::Reject;
+    else if (spec == "drop-oldest")
+        out = OverflowPolicy::DropOldest;
+    else if (spec == "drop-newest")
+        out = OverflowPolicy::DropNewest;
+    else
+        return false;
+    return true;
+}
+
+// CLOCK_MONOTONIC time timeout from now, for the timed waits below
+inline timespec monotonicDeadline(std::chrono::nanoseconds timeout)
+{
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    long long ns = t.tv_nsec + timeout.count();
+    t.tv_sec += ns / 1000000000;
+    t.tv_nsec = ns % 1000000000;
+    return t;
+}
+
+template <typename Sem>
+class BasicSemaphoreSync
+{
+public:
+    explicit BasicSemaphoreSync(size_t capacity)
+    {
+        sem_init(&sem_empty, 0, capacity);
+        sem_init(&sem_full, 0, 0);
+        sem_init(&sem_mutex, 0, 1);
+    }
+
+    ~BasicSemaphoreSync()
+    {
+        sem_destroy(&sem_empty);
+        sem_destroy(&sem_full);
+        sem_destroy(&sem_mutex);
+    }
+
+    BasicSemaphoreSync(const BasicSemaphoreSync &) = delete;
+    BasicSemaphoreSync &operator=(const BasicSemaphoreSync &) = delete;
+
+    void beginPush()
+    {
+        sem_wait(&sem_empty);
+        sem_wait(&sem_mutex);
+    }
+
+    bool tryBeginPush()
+    {
+        if (sem_trywait(&sem_empty) != 0)
+            return false;
+        sem_wait(&sem_mutex);
+        return true;
+    }
+
+    bool beginPushUntil(const timespec &deadline)
+    {
+        if (!waitUntil(sem_empty, deadline))
+            return false;
+        sem_wait(&sem_mutex);
+        return true;
+    }
+
+    void commitPush()
+    {
+        sem_post(&sem_mutex);
+        sem_post(&sem_full);
+    }
+
+    void abortPush()
+    {
+        sem_post(&sem_mutex);
+        sem_post(&sem_empty);
+    }
+
+    void beginPop()
+    {
+        sem_wait(&sem_full);
+        sem_wait(&sem_mutex);
+    }
+
+    bool tryBeginPop()
+    {
+        if (sem_trywait(&sem_full) != 0)
+            return false;
+        sem_wait(&sem_mutex);
+        return true;
+    }
+
+    bool beginPopUntil(const timespec &deadline)
+    {
+        if (!waitUntil(sem_full, deadline))
+            return false;
+        sem_wait(&sem_mutex);
+        return true;
+    }
+
+    void commitPop()
+    {
+        sem_post(&sem_mutex);
+        sem_post(&sem_empty);
+    }
+
+    void beginExclusive()
+    {
+        sem_wait(&sem_mutex);
+    }
+
+    void endExclusive()
+    {
+        sem_post(&sem_mutex);
+    }
+
+    // Waits for one empty token and takes up to max - 1 more without waiting
+    size_t reservePush(size_t max)
+    {
+        sem_wait(&sem_empty);
+        return 1 + tryTake(sem_empty, max - 1);
+    }
+
+    void beginReservedPush()
+    {
+        sem_wait(&sem_mutex);
+    }
+
+    // Publishes the first published of the claimed slots, frees the others
+    void finishPush(size_t published, size_t claimed)
+    {
+        sem_post(&sem_mutex);
+        for (size_t j = 0; j < published; j++)
+            sem_post(&sem_full);
+        for (size_t j = published; j < claimed; j++)
+            sem_post(&sem_empty);
+    }
+
+    size_t reservePop(size_t max)
+    {
+        sem_wait(&sem_full);
+        return 1 + tryTake(sem_full, max - 1);
+    }
+
+    size_t tryReservePop(size_t max)
+    {
+        return tryTake(sem_full, max);
+    }
+
+    void unreservePop()
+    {
+        sem_post(&sem_full);
+    }
+
+    void beginReservedPop()
+    {
+        sem_wait(&sem_mutex);
+    }
+
+    void finishPop(size_t taken, size_t claimed)
+    {
+        sem_post(&sem_mutex);
+        for (size_t j = 0; j < taken; j++)
+            sem_post(&sem_empty);
+        for (size_t j = taken; j < claimed; j++)
+            sem_post(&sem_full);
+    }
+
+    // Calls f on each semaphore, e.g. to add up FastSemaphore's counters
+    template <typename F>
+    void forEachSemaphore(F f) const
+    {
+        f(sem_empty);
+        f(sem_full);
+        f(sem_mutex);
+    }
+
+private:
+    static size_t tryTake(Sem &sem, size_t max)
+    {
+        size_t k = 0;
+        while (k < max && sem_trywait(&sem) == 0)
+            k++;
+        return k;
+    }
+
+    static bool waitUntil(Sem &sem, const timespec &deadline)
+    {
+        while (sem_clockwait(&sem, CLOCK_MONOTONIC, &deadline) != 0)
+            if (errno != EINTR)
+                return false;
+        return true;
+    }
+
+    Sem sem_empty;
+    Sem sem_full;
+    Sem sem_mutex;
+};
+
+typedef BasicSemaphoreSync<sem_t> SemaphoreSync;
+
+class MutexSync
+{
+public:
+    explicit MutexSync(size_t capacity) : capacity(capacity)
+    {
+        // The timed waits take CLOCK_MONOTONIC deadlines
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_mutex_init(&buffer_lock, NULL);
+        pthread_cond_init(&not_full, &attr);
+        pthread_cond_init(&not_empty, &attr);
+        pthread_condattr_destroy(&attr);
+    }
+
+    ~MutexSync()
+    {
+        pthread_mutex_destroy(&buffer_lock);
+        pthread_cond_destroy(&not_full);
+        pthread_cond_destroy(&not_empty);
+    }
+
+    MutexSync(const MutexSync &) = delete;
+    MutexSync &operator=(const MutexSync &) = delete;
+
+    void beginPush()
+    {
+        pthread_mutex_lock(&buffer_lock);
+        while (freeSlots() == 0)
+            pthread_cond_wait(&not_full, &buffer_lock);
+    }
+
+    bool tryBeginPush()
+    {
+        pthread_mutex_lock(&buffer_lock);
+        if (freeSlots() > 0)
+            return true;
+        pthread_mutex_unlock(&buffer_lock);
+        return false;
+    }
+
+    bool beginPushUntil(const timespec &deadline)
+    {
+        pthread_mutex_lock(&buffer_lock);
+        while (freeSlots() == 0)
+            if (pthread_cond_timedwait(&not_full, &buffer_lock, &deadline) == ETIMEDOUT && freeSlots() == 0)
+            {
+                pthread_mutex_unlock(&buffer_lock);
+                return false;
+            }
+        return true;
+    }
+
+    void commitPush()
+    {
+        count_items++;
+        pthread_mutex_unlock(&buffer_lock);
+        pthread_cond_signal(&not_empty);
+    }
+
+    void abortPush()
+    {
+        pthread_mutex_unlock(&buffer_lock);
+    }
+
+    void beginPop()
+    {
+        pthread_mutex_lock(&buffer_lock);
+        while (readyItems() == 0)
+            pthread_cond_wait(&not_empty, &buffer_lock);
+    }
+
+    bool tryBeginPop()
+    {
+        pthread_mutex_lock(&buffer_lock);
+        if (readyItems() > 0)
+            return true;
+        pthread_mutex_unlock(&buffer_lock);
+        return false;
+    }
+
+    bool beginPopUntil(const timespec &deadline)
+    {
+        pthread_mutex_lock(&buffer_lock);
+        while (readyItems() == 0)
+            if (pthread_cond_timedwait(&not_empty, &buffer_lock, &deadline) == ETIMEDOUT && readyItems() == 0)
+            {
+                pthread_mutex_unlock(&buffer_lock);
+                return false;
+            }
+        return true;
+    }
+
+    void commitPop()
+    {
+        count_items--;
+        pthread_mutex_unlock(&buffer_lock);
+        pthread_cond_signal(&not_full);
+    }
+
+    void beginExclusive()
+    {
+        pthread_mutex_lock(&buffer_lock);
+    }
+
+    void endExclusive()
+    {
+        pthread_mutex_unlock(&buffer_lock);
+    }
+
+    // Waits for one unclaimed free slot and claims up to max of them
+    size_t reservePush(size_t max)
+    {
+        pthread_mutex_lock(&buffer_lock);
+        while (freeSlots() == 0)
+            pthread_cond_wait(&not_full, &buffer_lock);
+        size_t k = std::min(max, freeSlots());
+        claimed_slots += k;
+        pthread_mutex_unlock(&buffer_lock);
+        return k;
+    }
+
+    void beginReservedPush()
+    {
+        pthread_mutex_lock(&buffer_lock);
+    }
+
+    // Publishes the first published of the claimed slots, frees the others
+    void finishPush(size_t published, size_t claimed)
+    {
+        count_items += published;
+        claimed_slots -= claimed;
+        pthread_mutex_unlock(&buffer_lock);
+        wake(not_empty, published);
+        wake(not_full, claimed - published);
+    }
+
+    size_t reservePop(size_t max)
+    {
+        pthread_mutex_lock(&buffer_lock);
+        while (readyItems() == 0)
+            pthread_cond_wait(&not_empty, &buffer_lock);
+        size_t k = std::min(max, readyItems());
+        claimed_items += k;
+        pthread_mutex_unlock(&buffer_lock);
+        return k;
+    }
+
+    size_t tryReservePop(size_t max)
+    {
+        pthread_mutex_lock(&buffer_lock);
+        size_t k = std::min(max, readyItems());
+        claimed_items += k;
+        pthread_mutex_unlock(&buffer_lock);
+        return k;
+    }
+
+    void unreservePop()
+    {
+        pthread_mutex_lock(&buffer_lock);
+        claimed_items--;
+        pthread_mutex_unlock(&buffer_lock);
+        pthread_cond_signal(&not_empty);
+    }
+
+    void beginReservedPop()
+    {
+        pthread_mutex_lock(&buffer_lock);
+    }
+
+    void finishPop(size_t taken, size_t claimed)
+    {
+        count_items -= taken;
+        claimed_items -= claimed;
+        pthread_mutex_unlock(&buffer_lock);
+        wake(not_full, taken);
+        wake(not_empty, claimed - taken);
+    }
+
+private:
+    // Slots (items) that no reservation has claimed; buffer_lock held
+    size_t freeSlots() const
+    {
+        return capacity - count_items - claimed_slots;
+    }
+
+    size_t readyItems() const
+    {
+        return count_items - claimed_items;
+    }
+
+    // More than one slot or item may be enough for several waiters
+    static void wake(pthread_cond_t &cond, size_t n)
+    {
+        if (n > 1)
+            pthread_cond_broadcast(&cond);
+        else if (n == 1)
+            pthread_cond_signal(&cond);
+    }
+
+    const size_t capacity;
+    size_t count_items = 0;
+    // Claimed by reservePush (reservePop) and not yet finished
+    size_t claimed_slots = 0;
+    size_t claimed_items = 0;
+    pthread_mutex_t buffer_lock;
+    pthread_cond_t not_full;
+    pthread_cond_t not_empty;
+};
+
+template <typename T, typename SyncPolicy>
+class BoundedBuffer
+{
+    static_assert(std::is_nothrow_move_assignable<T>::value && std::is_nothrow_destructible<T>::value,
+                  "popInto moves out of the slot while holding the buffer; that must not throw");
+
+public:
+    explicit BoundedBuffer(size_t capacity, OverflowPolicy overflow = OverflowPolicy::Block)
+        : cap(capacity), overflow(overflow), slots(new Slot[capacity]), sync(capacity)
+    {
+    }
+
+    // Destroys the items nobody popped
+    ~BoundedBuffer()
+    {
+        for (unsigned long long i = out_index; i != in_index; i++)
+            item(i % cap)->~T();
+    }
+
+    BoundedBuffer(const BoundedBuffer &) = delete;
+    BoundedBuffer &operator=(const BoundedBuffer &) = delete;
+
+    size_t capacity() const
+    {
+        return cap;
+    }
+
+    // The policy object, e.g. for the counters of its semaphores
+    const SyncPolicy &synchronization() const
+    {
+        return sync;
+    }
+
+    // Blocks until a slot is free and constructs T(args...) in it; returns the
+    // slot index. If the constructor throws the slot is released again.
+    template <typename... Args>
+    size_t emplace(Args &&...args)
+    {
+        sync.beginPush();
+        return construct(std::forward<Args>(args)...);
+    }
+
+    size_t push(T &&value)
+    {
+        return emplace(std::move(value));
+    }
+
+    // Constructs the item only if a slot is free right now
+    template <typename... Args>
+    bool tryEmplace(Args &&...args)
+    {
+        if (!sync.tryBeginPush())
+            return false;
+        construct(std::forward<Args>(args)...);
+        return true;
+    }
+
+    bool tryPush(T &&value)
+    {
+        return tryEmplace(std::move(value));
+    }
+
+    // Waits at most timeout for a free slot
+    template <typename... Args>
+    bool emplaceFor(std::chrono::nanoseconds timeout, Args &&...args)
+    {
+        if (!sync.beginPushUntil(monotonicDeadline(timeout)))
+            return false;
+        construct(std::forward<Args>(args)...);
+        return true;
+    }
+
+    bool pushFor(std::chrono::nanoseconds timeout, T &&value)
+    {
+        return emplaceFor(timeout, std::move(value));
+    }
+
+    // Pushes T(args...) according to the buffer's overflow policy. With
+    // DropOldest the oldest item is popped and destroyed until the new one
+    // fits, which may take more than one try when other producers are
+    // pushing too; the new item is only constructed if it goes in. With
+    // DropNewest the item is always built, then moved over the item that went
+    // in last if the buffer is still full once it holds the whole buffer.
+    template <typename... Args>
+    PushResult offer(Args &&...args)
+    {
+        switch (overflow)
+        {
+        case OverflowPolicy::Block:
+            emplace(std::forward<Args>(args)...);
+            return PushResult::Pushed;
+        case OverflowPolicy::Reject:
+            return tryEmplace(std::forward<Args>(args)...) ? PushResult::Pushed : PushResult::Rejected;
+        case OverflowPolicy::DropNewest:
+        {
+            T value(std::forward<Args>(args)...);
+            for (;;)
+            {
+                if (sync.tryBeginPush())
+                {
+                    construct(std::move(value));
+                    return PushResult::Pushed;
+                }
+                // A slot freed between the two checks sends it round again
+                sync.beginExclusive();
+                if (in_index - out_index == cap)
+                {
+                    *item((in_index - 1) % cap) = std::move(value);
+                    sync.endExclusive();
+                    return PushResult::DroppedNewest;
+                }
+                sync.endExclusive();
+            }
+        }
+        case OverflowPolicy::DropOldest:
+        default:
+            bool dropped = false;
+            while (!sync.tryBeginPush())
+            {
+                if (sync.tryBeginPop())
+                {
+                    item(out_index % cap)->~T();
+                    out_index++;
+                    sync.commitPop();
+                    dropped = true;
+                }
+            }
+            construct(std::forward<Args>(args)...);
+            return dropped ? PushResult::DroppedOldest : PushResult::Pushed;
+        }
+    }
+
+    // Blocks until an item is ready and move-assigns it to out; returns the
+    // slot index it came from
+    size_t popInto(T &out)
+    {
+        sync.beginPop();
+        return take(out);
+    }
+
+    // Pops only if an item is ready right now
+    bool tryPopInto(T &out)
+    {
+        if (!sync.tryBeginPop())
+            return false;
+        take(out);
+        return true;
+    }
+
+    // Waits at most timeout for an item
+    bool popIntoFor(std::chrono::nanoseconds timeout, T &out)
+    {
+        if (!sync.beginPopUntil(monotonicDeadline(timeout)))
+            return false;
+        take(out);
+        return true;
+    }
+
+    // Two-step batches (see the top of the file). reservePush waits for one
+    // free slot and claims up to max (at least 1) of them; returns how many.
+    size_t reservePush(size_t max)
+    {
+        return sync.reservePush(max);
+    }
+
+    size_t reservePop(size_t max)
+    {
+        return sync.reservePop(max);
+    }
+
+    // Claims up to max ready items without waiting; returns how many
+    size_t tryReservePop(size_t max)
+    {
+        return sync.tryReservePop(max);
+    }
+
+    // Gives back one claimed item without popping it
+    void unreservePop()
+    {
+        sync.unreservePop();
+    }
+
+    // Holds the push side for claimed slots and fills them in order. The
+    // destructor publishes the items built and frees the other slots, so a
+    // throwing constructor loses no slot.
+    class PushBatch
+    {
+    public:
+        PushBatch(BoundedBuffer &buffer, size_t claimed) : buffer(buffer), claimed(claimed)
+        {
+            buffer.sync.beginReservedPush();
+        }
+
+        ~PushBatch()
+        {
+            buffer.sync.finishPush(built, claimed);
+        }
+
+        PushBatch(const PushBatch &) = delete;
+        PushBatch &operator=(const PushBatch &) = delete;
+
+        // Constructs T(args...) in the next claimed slot; returns its index
+        template <typename... Args>
+        size_t emplace(Args &&...args)
+        {
+            size_t pos = buffer.in_index % buffer.cap;
+            ::new (static_cast<void *>(buffer.item(pos))) T(std::forward<Args>(args)...);
+            buffer.in_index++;
+            built++;
+            return pos;
+        }
+
+    private:
+        BoundedBuffer &buffer;
+        const size_t claimed;
+        size_t built = 0;
+    };
+
+    // Holds the pop side for claimed items; the destructor frees the slots
+    // taken and gives back the claims not used
+    class PopBatch
+    {
+    public:
+        PopBatch(BoundedBuffer &buffer, size_t claimed) : buffer(buffer), claimed(claimed)
+        {
+            buffer.sync.beginReservedPop();
+        }
+
+        ~PopBatch()
+        {
+            buffer.sync.finishPop(taken, claimed);
+        }
+
+        PopBatch(const PopBatch &) = delete;
+        PopBatch &operator=(const PopBatch &) = delete;
+
+        // Moves the oldest item to out; returns the slot index it came from
+        size_t popInto(T &out)
+        {
+            size_t pos = buffer.out_index % buffer.cap;
+            T *slot = buffer.item(pos);
+            out = std::move(*slot);
+            slot->~T();
+            buffer.out_index++;
+            taken++;
+            return pos;
+        }
+
+    private:
+        BoundedBuffer &buffer;
+        const size_t claimed;
+        size_t taken = 0;
+    };
+
+private:
+    struct Slot
+    {
+        alignas(T) unsigned char bytes[sizeof(T)];
+    };
+
+    T *item(size_t pos)
+    {
+        return std::launder(reinterpret_cast<T *>(slots[pos].bytes));
+    }
+
+    // With the push side held: builds the item in the next slot and publishes it
+    template <typename... Args>
+    size_t construct(Args &&...args)
+    {
+        size_t pos = in_index % cap;
+        try
+        {
+            ::new (static_cast<void *>(item(pos))) T(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            sync.abortPush();
+            throw;
+        }
+        in_index++;
+        sync.commitPush();
+        return pos;
+    }
+
+    // With the pop side held: moves the oldest item out and frees its slot
+    size_t take(T &out)
+    {
+        size_t pos = out_index % cap;
+        T *slot = item(pos);
+        out = std::move(*slot);
+        slot->~T();
+        out_index++;
+        sync.commitPop();
+        return pos;
+    }
+
+    const size_t cap;
+    const OverflowPolicy overflow;
+    std::unique_ptr<Slot[]> slots;
+    // Only touched with the push (pop) side held, they only ever grow; with
+    // exclusive access in_index - out_index is the number of items
+    unsigned long long in_index = 0;
+    unsigned long long out_index = 0;
+    SyncPolicy sync;
+};
+
+#endif
@@ -0,0 +1,245 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <cstdlib>
+#include <algorithm>
+#include "coro_scheduler.h"
+#include "coro_buffer.h"
+#include "latency_histogram.h"
+#include "pacing.h"
+
+using namespace std;
+using namespace std::chrono;
+
+// Coroutine version (C++20): every producer and consumer is a CoroTask, and
+// a pool of --workers=N threads (default: one per CPU) runs them all
+// (coro_scheduler.h). Pushing to a full buffer, popping from an empty one
+// and the delays between items suspend the task instead of blocking a
+// thread, so np and nc can be in the tens of thousands. Input, log format
+// and summary are those of the other versions; thread ids in the log are
+// task ids.
+
+int capacity, np, nc, cntp, cntc;
+double mu_p, mu_c;
+struct Item
+{
+    int id;
+};
+CoroScheduler *scheduler = nullptr;
+CoroBuffer<Item> *buffer = nullptr;
+
+// How producers space their items (--arrival=exp|const|bursty[:ON_MS:OFF_MS])
+ArrivalProcess arrival;
+
+// Seed of the delay generators, random unless --seed=N; task i uses seed + i
+unsigned seed = random_device{}();
+
+// Queueing latency (dequeue minus enqueue time) recorded by each consumer
+vector<LatencyHistogram> latencyHists;
+
+vector<string> logBuffers;
+
+steady_clock::time_point base_time;
+
+void writeOutputToFile(const string &output)
+{
+    ofstream outFile("output_coro.txt", ios::app);
+    if (outFile)
+        outFile << output << endl;
+    else
+        cout << "Error: Could not open output file." << endl;
+    outFile.close();
+}
+
+vector<string> splitByNewline(const string &buffer)
+{
+    vector<string> lines;
+    size_t start = 0, end;
+    while ((end = buffer.find('\n', start)) != string::npos)
+    {
+        string line = buffer.substr(start, end - start);
+        if (!line.empty())
+            lines.push_back(line);
+        start = end + 1;
+    }
+    if (start < buffer.size())
+        lines.push_back(buffer.substr(start));
+    return lines;
+}
+
+void parseAndWriteLogs(const vector<string> &buffers)
+{
+    vector<pair<long long, string>> logs;
+    for (const string &buffer : buffers)
+    {
+        vector<string> lines = splitByNewline(buffer);
+        for (const string &line : lines)
+        {
+            size_t lastSpace = line.find_last_of(' ');
+            if (lastSpace != string::npos)
+            {
+                string logMessage = line.substr(0, lastSpace);
+                string lastToken = line.substr(lastSpace + 1);
+                try
+                {
+                    long long timestamp = stoll(lastToken);
+                    logs.emplace_back(timestamp, logMessage);
+                }
+                catch (const std::invalid_argument &e)
+                {
+                    // Skip lines where the last token is not a number (e.g., total execution time line)
+                    continue;
+                }
+            }
+        }
+    }
+    sort(logs.begin(), logs.end(), [](const pair<long long, string> &a, const pair<long long, string> &b)
+         { return a.first < b.first; });
+    // Clear the output file first
+    ofstream clearFile("output_coro.txt", ios::out);
+    clearFile.close();
+    for (const auto &log : logs)
+    {
+        writeOutputToFile(log.second + " " + to_string(log.first));
+    }
+}
+
+long long getTimestamp()
+{
+    auto now = steady_clock::now();
+    return duration_cast<nanoseconds>(now - base_time).count();
+}
+
+CoroTask producer(int global_id)
+{
+    // Open-loop arrivals (--arrival=, exponential by default)
+    Pacer pacer(arrival, mu_p, seed + global_id);
+
+    for (int i = 0; i < cntp; i++)
+    {
+        // Suspends while the buffer is full
+        long long cs_entry = getTimestamp();
+        size_t pos = co_await buffer->push(Item{global_id * 1000 + i});
+        long long cs_exit = getTimestamp();
+        {
+            ostringstream oss;
+            oss << "PROD_CS: " << global_id << " " << cs_entry << " " << cs_exit;
+            logBuffers[global_id] += oss.str() + "\n";
+        }
+        {
+            ostringstream oss;
+            oss << (i + 1) << "th item produced by thread " << global_id
+                << " at " << cs_exit << " ms into buffer location " << pos;
+            logBuffers[global_id] += oss.str() + "\n";
+        }
+
+        co_await scheduler->sleepUntil(pacer.arrivalDeadline());
+    }
+}
+
+CoroTask consumer(int global_id)
+{
+    // Exponentially distributed processing time per item (mean = mu_c ms)
+    Pacer pacer(ArrivalProcess(), mu_c, seed + global_id);
+
+    for (int i = 0; i < cntc; i++)
+    {
+        // Suspends while the buffer is empty
+        long long cs_entry = getTimestamp();
+        CoroBuffer<Item>::Popped popped = co_await buffer->pop();
+        long long cs_exit = getTimestamp();
+        {
+            ostringstream oss;
+            oss << "CONS_CS: " << global_id << " " << cs_entry << " " << cs_exit;
+            logBuffers[global_id] += oss.str() + "\n";
+        }
+        {
+            ostringstream oss;
+            oss << (i + 1) << "th item consumed by thread " << global_id
+                << " at " << cs_exit << " ms from buffer location " << popped.pos;
+            logBuffers[global_id] += oss.str() + "\n";
+        }
+        latencyHists[global_id - np].record(cs_exit - popped.enqueuedNs);
+
+        co_await scheduler->sleepUntil(pacer.delayDeadline());
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        cerr << "Usage: " << argv[0] << " inp-params.txt [--workers=N] [--arrival=MODE] [--seed=N]" << endl;
+        return 1;
+    }
+    size_t workers = max(1u, thread::hardware_concurrency());
+    for (int i = 2; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg.rfind("--workers=", 0) == 0)
+            workers = static_cast<size_t>(max(1, stoi(arg.substr(10))));
+        else if (arg.rfind("--seed=", 0) == 0)
+            seed = static_cast<unsigned>(stoul(arg.substr(7)));
+        else if (arg.rfind("--arrival=", 0) != 0 || !parseArrivalProcess(arg.substr(10), arrival))
+        {
+            cerr << "Usage: " << argv[0] << " inp-params.txt [--workers=N] [--arrival=MODE] [--seed=N]" << endl;
+            return 1;
+        }
+    }
+
+    ifstream inputFile(argv[1]);
+    if (!inputFile)
+    {
+        cerr << "Error: Cannot open input file " << argv[1] << endl;
+        return 1;
+    }
+    inputFile >> capacity >> np >> nc >> cntp >> cntc >> mu_p >> mu_c;
+    inputFile.close();
+
+    if (capacity < 1)
+    {
+        cerr << "Error: capacity must be positive" << endl;
+        return 1;
+    }
+    scheduler = new CoroScheduler(workers);
+    buffer = new CoroBuffer<Item>(capacity, *scheduler, getTimestamp);
+
+    int totalTasks = np + nc;
+    logBuffers.resize(totalTasks, "");
+    latencyHists.assign(nc, LatencyHistogram());
+
+    base_time = steady_clock::now();
+
+    for (int i = 0; i < np; i++)
+        scheduler->spawn(producer(i));
+    for (int i = 0; i < nc; i++)
+        scheduler->spawn(consumer(i + np));
+    scheduler->run();
+    long long elapsed_ns = getTimestamp();
+
+    long long totalDuration = duration_cast<milliseconds>(steady_clock::now() - base_time).count();
+    ostringstream oss;
+    oss << "Total execution time: " << totalDuration << " ms";
+    logBuffers[0] += oss.str() + "\n";
+
+    parseAndWriteLogs(logBuffers);
+
+    LatencyHistogram latency;
+    for (const LatencyHistogram &h : latencyHists)
+        latency.merge(h);
+    for (const string &line : latency.reportLines())
+        cout << line << endl;
+    cout << "Throughput: " << to_string(latency.count() * 1e9 / max(elapsed_ns, 1LL)) << " items/s" << endl;
+    cout << "Coroutines: " << totalTasks << " tasks on " << scheduler->workerCount() << " worker threads, "
+         << scheduler->resumes() << " resumes, " << scheduler->timerWaits() << " timer waits, "
+         << buffer->producerWaits() << " waits on a full buffer, " << buffer->consumerWaits() << " on an empty one" << endl;
+
+    delete buffer;
+    delete scheduler;
+
+    return 0;
+}
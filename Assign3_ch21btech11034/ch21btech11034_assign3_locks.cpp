@@ -8,17 +8,107 @@
 #include <pthread.h>
 #include <cstdlib>
 #include <algorithm>
+#include <atomic>
+#include "bounded_buffer.h"
+#include "chrome_trace.h"
+#include "latency_histogram.h"
+#include "pacing.h"
+#include "priority_lanes.h"
 
 using namespace std;
 using namespace std::chrono;
 
+// -DPOLL_WAIT keeps the original wait (unlock, sleep 1 ms, retry) so the two
+// strategies can be compared; by default waiters block on a condition variable
+#ifdef POLL_WAIT
+constexpr bool pollWait = true;
+#else
+constexpr bool pollWait = false;
+#endif
+
 int capacity, np, nc, cntp, cntc;
 double mu_p, mu_c;
-vector<int> buffer;
-int in_index = 0, out_index = 0;
+// Items carry the time they were put in the buffer and their priority lane
+struct Item
+{
+    int id;
+    long long enqueue_ns;
+    int lane;
+};
+// The buffer's slots, split into priority lanes (priority_lanes.h); with the
+// default single lane it is the original FIFO ring
+PriorityLanes<Item> *buffer = nullptr;
+
+// Queueing latency (dequeue minus enqueue time) recorded by each consumer,
+// overall and per lane
+vector<LatencyHistogram> latencyHists;
+vector<vector<LatencyHistogram>> laneHists;
 int count_items = 0; 
 
+// Priority lanes (--lanes=P, 1 to 8) and how consumers choose among them
+// (--lane-policy=strict|wrr). With aging (--aging-ms=X, 0 turns it off) an
+// item that has waited X ms is taken before more urgent ones. Producers give
+// lane l a share of their items proportional to 2^l, so lane 0 is the
+// rarest, most urgent traffic and the last lane the bulk.
+int numLanes = 1;
+LanePolicy lanePolicy = LanePolicy::Strict;
+double agingMs = 50;
+
 pthread_mutex_t buffer_lock;
+pthread_cond_t not_full;
+pthread_cond_t not_empty;
+
+// Upper bound on the adaptive spin before blocking (--spin=N, 0 disables)
+int maxSpin = 50;
+
+// Items moved per lock acquisition (--batch=B, default 1)
+int batch = 1;
+
+// How producers space their items (--arrival=exp|const|bursty[:ON_MS:OFF_MS])
+ArrivalProcess arrival;
+
+// Seed of the delay generators, random unless --seed=N; thread i uses seed + i
+unsigned seed = random_device{}();
+
+// What a producer does when the buffer is full (--overflow=block|reject|
+// drop-oldest|drop-newest, default block). With block, --push-timeout-ms=X
+// bounds the wait; an item that gets no slot in time is given up. Any of
+// these means fewer items than np * cntp may reach the consumers, so they
+// imply --drain.
+OverflowPolicy overflow = OverflowPolicy::Block;
+double pushTimeoutMs = 0;
+// Per producer: items refused, discarded newest and oldest (from the
+// buffer, to make room) and given up after the push timeout
+vector<long long> rejectedItems, droppedNewItems, droppedOldItems, timedOutItems;
+
+// Close/drain (--drain, implied by --elastic): producers finish on their own,
+// main closes the buffer once they have, and consumers take items until it is
+// closed and empty instead of exactly cntc each, so np * cntp need not equal
+// nc * cntc
+bool drainMode = false;
+bool closed = false; // guarded by buffer_lock
+
+// Elastic consumer pool (--elastic=MIN:MAX). maxConsumers consumer threads
+// exist; those with index >= targetConsumers are parked on unparked. Every
+// SUPERVISOR_PERIOD_MS the supervisor samples buffer occupancy and the share
+// of time the active consumers spent waiting for items, and adds a consumer
+// when the buffer is at least half full or parks one when it is nearly empty
+// and the consumers mostly idle.
+bool elastic = false;
+int minConsumers = 1, maxConsumers = 1;
+atomic<int> targetConsumers{0};
+atomic<bool> supervising{false};
+bool poolClosed = false; // guarded by pool_lock
+pthread_mutex_t pool_lock;
+pthread_cond_t unparked;
+const int SUPERVISOR_PERIOD_MS = 10;
+int poolAdds = 0, poolParks = 0, poolPeak = 0;
+
+// Per consumer slot: time spent waiting for items, the start of the current
+// wait (0 when not waiting) and time spent active (not parked)
+vector<atomic<long long>> consumerIdleNs;
+vector<atomic<long long>> consumerWaitingSince;
+vector<long long> consumerActiveNs;
 
 vector<string> logBuffers;
 
@@ -93,18 +183,156 @@ long long getTimestamp()
     return duration_cast<nanoseconds>(now - base_time).count();
 }
 
-void *producer(void *arg)
+bool notFull()
 {
-    int global_id = *(int *)arg;
-    default_random_engine generator(random_device{}());
-    exponential_distribution<double> exp_dist(1.0 / mu_p); 
+    return count_items < capacity;
+}
 
-    for (int i = 0; i < cntp; i++)
+bool notEmpty()
+{
+    return count_items > 0;
+}
+
+bool notEmptyOrClosed()
+{
+    return count_items > 0 || closed;
+}
+
+// Parks consumer slot idx while the supervisor does not want it; its active
+// time stops counting meanwhile. Returns false when the pool shuts down with
+// the slot still parked.
+bool waitUntilActive(int idx, long long &activeSince)
+{
+    if (idx < targetConsumers.load(memory_order_acquire))
+        return true;
+    consumerActiveNs[idx] += getTimestamp() - activeSince;
+    pthread_mutex_lock(&pool_lock);
+    while (idx >= targetConsumers.load(memory_order_relaxed) && !poolClosed)
+        pthread_cond_wait(&unparked, &pool_lock);
+    bool active = idx < targetConsumers.load(memory_order_relaxed);
+    pthread_mutex_unlock(&pool_lock);
+    if (active)
+        activeSince = getTimestamp();
+    return active;
+}
+
+void setTargetConsumers(int target)
+{
+    pthread_mutex_lock(&pool_lock);
+    targetConsumers.store(target, memory_order_release);
+    pthread_mutex_unlock(&pool_lock);
+    pthread_cond_broadcast(&unparked);
+}
+
+// Waiting time of consumer slot i so far, including a wait in progress
+long long idleSoFar(int i, long long now)
+{
+    long long since = consumerWaitingSince[i].load(memory_order_relaxed);
+    return consumerIdleNs[i].load(memory_order_relaxed) + (since > 0 ? now - since : 0);
+}
+
+void *supervisor(void *)
+{
+    vector<long long> lastIdle(maxConsumers, 0);
+    long long lastSample = getTimestamp();
+    while (supervising.load(memory_order_acquire))
     {
-        int item = global_id * 1000 + i;
+        this_thread::sleep_for(chrono::milliseconds(SUPERVISOR_PERIOD_MS));
+        long long now = getTimestamp();
+        long long period = max(now - lastSample, 1LL);
+        lastSample = now;
 
         pthread_mutex_lock(&buffer_lock);
-        long long cs_entry = getTimestamp();
+        double occupancy = static_cast<double>(count_items) / capacity;
+        pthread_mutex_unlock(&buffer_lock);
+
+        int target = targetConsumers.load(memory_order_relaxed);
+        long long idle = 0;
+        for (int i = 0; i < maxConsumers; i++)
+        {
+            long long total = idleSoFar(i, now);
+            if (i < target)
+                idle += total - lastIdle[i];
+            lastIdle[i] = total;
+        }
+        double idleShare = static_cast<double>(idle) / (static_cast<double>(target) * period);
+
+        if (occupancy >= 0.5 && target < maxConsumers)
+        {
+            setTargetConsumers(target + 1);
+            poolAdds++;
+            poolPeak = max(poolPeak, target + 1);
+        }
+        else if (occupancy <= 0.1 && idleShare >= 0.5 && target > minConsumers)
+        {
+            setTargetConsumers(target - 1);
+            poolParks++;
+        }
+    }
+    pthread_exit(NULL);
+    return NULL;
+}
+
+// Adaptive spin before blocking: up to budget rounds of trylock, check and
+// yield. Returns true with buffer_lock held and the condition true. The budget
+// doubles (up to maxSpin) when spinning pays off and halves when the thread
+// has to block anyway, so spinning fades out when the other side is slow.
+bool spinAcquire(int &budget, bool (*ready)())
+{
+    for (int round = 0; round < budget; round++)
+    {
+        if (pthread_mutex_trylock(&buffer_lock) == 0)
+        {
+            if (ready())
+            {
+                budget = min(budget * 2, maxSpin);
+                return true;
+            }
+            pthread_mutex_unlock(&buffer_lock);
+        }
+        this_thread::yield();
+    }
+    budget = max(budget / 2, maxSpin > 0 ? 1 : 0);
+    return false;
+}
+
+// Takes buffer_lock for a push and waits for a free slot as far as the
+// overflow policy and push timeout allow. Returns true with a slot free, or
+// false, with the lock still held, when the buffer is full and the producer
+// has to give up or make room.
+bool lockForPush(int &spinBudget, long long &cs_entry)
+{
+    if (overflow != OverflowPolicy::Block)
+    {
+        pthread_mutex_lock(&buffer_lock);
+        cs_entry = getTimestamp();
+        return count_items < capacity;
+    }
+    if (pushTimeoutMs > 0)
+    {
+        nanoseconds timeout(static_cast<long long>(pushTimeoutMs * 1e6));
+        timespec deadline = monotonicDeadline(timeout);
+        pthread_mutex_lock(&buffer_lock);
+        cs_entry = getTimestamp();
+        while (count_items == capacity)
+        {
+            if constexpr (pollWait)
+            {
+                if (getTimestamp() - cs_entry >= timeout.count())
+                    return false;
+                pthread_mutex_unlock(&buffer_lock);
+                this_thread::sleep_for(chrono::milliseconds(1));
+                pthread_mutex_lock(&buffer_lock);
+            }
+            else if (pthread_cond_timedwait(&not_full, &buffer_lock, &deadline) == ETIMEDOUT && count_items == capacity)
+                return false;
+        }
+        return true;
+    }
+    if constexpr (pollWait)
+    {
+        pthread_mutex_lock(&buffer_lock);
+        cs_entry = getTimestamp();
         while (count_items == capacity)
         {
             // Buffer full: release lock and wait briefly before retrying
@@ -112,27 +340,141 @@ void *producer(void *arg)
             this_thread::sleep_for(chrono::milliseconds(1));
             pthread_mutex_lock(&buffer_lock);
         }
-        
-        int pos = in_index;
-        buffer[in_index] = item;
-        in_index = (in_index + 1) % capacity;
-        count_items++;
-        long long cs_exit = getTimestamp();
-        {
-            ostringstream oss;
-            oss << "PROD_CS: " << global_id << " " << cs_entry << " " << cs_exit;
-            logBuffers[global_id] += oss.str() + "\n";
-        }
+    }
+    else if (spinAcquire(spinBudget, notFull))
+        cs_entry = getTimestamp();
+    else
+    {
+        pthread_mutex_lock(&buffer_lock);
+        cs_entry = getTimestamp();
+        // Buffer full: sleep until a consumer frees a slot
+        while (count_items == capacity)
+            pthread_cond_wait(&not_full, &buffer_lock);
+    }
+    return true;
+}
+
+void *producer(void *arg)
+{
+    int global_id = *(int *)arg;
+    // Open-loop arrivals (--arrival=, exponential by default)
+    Pacer pacer(arrival, mu_p, seed + global_id);
+    int spinBudget = maxSpin;
+    vector<int> positions(batch);
+    vector<int> itemLanes(batch);
+    mt19937 laneRng(seed + global_id);
+    vector<double> laneShares;
+    for (int l = 0; l < numLanes; l++)
+        laneShares.push_back(1 << l);
+    discrete_distribution<int> laneMix(laneShares.begin(), laneShares.end());
+
+    // Items are produced in bursts of up to batch items, then the thread
+    // sleeps for the sum of their delays, so cntp and the mean rate are kept
+    for (int i = 0; i < cntp;)
+    {
+        int burst = min(batch, cntp - i);
+        int done = 0;
+        while (done < burst)
         {
-            ostringstream oss;
-            oss << (i + 1) << "th item produced by thread " << global_id
-                << " at " << cs_exit << " ms into buffer location " << pos;
-            logBuffers[global_id] += oss.str() + "\n";
+            // push_n: one lock acquisition fills as many free slots as the burst needs
+            long long waitStart = chromeTraceNow();
+            long long cs_entry;
+            bool room = lockForPush(spinBudget, cs_entry);
+            long long csStart = chromeTraceNow();
+            chromeTraceSpan(global_id, "wait", waitStart, csStart);
+            if (!room && (overflow == OverflowPolicy::DropOldest || overflow == OverflowPolicy::DropNewest))
+            {
+                // Make room by discarding the item that has waited longest,
+                // or the one that went in last
+                Item old;
+                size_t lane;
+                int pos;
+                if (overflow == OverflowPolicy::DropOldest)
+                {
+                    pos = buffer->dropOldest(old, lane);
+                    droppedOldItems[global_id]++;
+                }
+                else
+                {
+                    pos = buffer->dropNewest(old, lane);
+                    droppedNewItems[global_id]++;
+                }
+                count_items--;
+                ostringstream oss;
+                oss << "item " << old.id << " dropped by thread " << global_id << " at " << getTimestamp() << " ms from ";
+                if (numLanes > 1)
+                    oss << "lane " << lane << " ";
+                oss << "buffer location " << pos;
+                logBuffers[global_id] += oss.str() + "\n";
+                room = true;
+            }
+            if (!room)
+            {
+                // Shed the item instead of waiting for a slot
+                long long cs_exit = getTimestamp();
+                int buffered = count_items;
+                const char *what;
+                if (overflow == OverflowPolicy::Reject)
+                {
+                    rejectedItems[global_id]++;
+                    what = "rejected";
+                }
+                else
+                {
+                    timedOutItems[global_id]++;
+                    what = "timed out";
+                }
+                chromeTraceSpan(global_id, "shed", csStart, chromeTraceNow());
+                pthread_mutex_unlock(&buffer_lock);
+                ostringstream oss;
+                oss << (i + done + 1) << "th item " << what << " by thread " << global_id
+                    << " at " << cs_exit << " ms, items in buffer " << buffered;
+                logBuffers[global_id] += oss.str() + "\n";
+                done++;
+                continue;
+            }
+
+            int k = min(burst - done, capacity - count_items);
+            for (int j = 0; j < k; j++)
+            {
+                long long now = getTimestamp();
+                itemLanes[j] = laneMix(laneRng);
+                positions[j] = buffer->push({global_id * 1000 + i + done + j, now, itemLanes[j]}, itemLanes[j], now);
+            }
+            count_items += k;
+            long long cs_exit = getTimestamp();
+            {
+                ostringstream oss;
+                oss << "PROD_CS: " << global_id << " " << cs_entry << " " << cs_exit;
+                logBuffers[global_id] += oss.str() + "\n";
+            }
+            for (int j = 0; j < k; j++)
+            {
+                ostringstream oss;
+                oss << (i + done + j + 1) << "th item produced by thread " << global_id << " at " << cs_exit << " ms into ";
+                if (numLanes > 1)
+                    oss << "lane " << itemLanes[j] << " ";
+                oss << "buffer location " << positions[j];
+                logBuffers[global_id] += oss.str() + "\n";
+            }
+            chromeTraceSpan(global_id, "CS", csStart, chromeTraceNow());
+            pthread_mutex_unlock(&buffer_lock);
+            if constexpr (!pollWait)
+            {
+                // More than one item may be enough for several waiting consumers
+                if (k > 1)
+                    pthread_cond_broadcast(&not_empty);
+                else
+                    pthread_cond_signal(&not_empty);
+            }
+            done += k;
         }
-        pthread_mutex_unlock(&buffer_lock);
+        i += burst;
 
-        double delay_ms = exp_dist(generator);
-        this_thread::sleep_for(chrono::milliseconds(static_cast<int>(delay_ms)));
+        // Wait for the arrival of the next burst (one gap per item)
+        long long workStart = chromeTraceNow();
+        pacer.nextArrival(burst);
+        chromeTraceSpan(global_id, "work", workStart, chromeTraceNow());
     }
     pthread_exit(NULL);
     return NULL;
@@ -142,23 +484,71 @@ void *producer(void *arg)
 void *consumer(void *arg)
 {
     int global_id = *(int *)arg;
-    default_random_engine generator(random_device{}());
-    exponential_distribution<double> exp_dist(1.0 / mu_c); 
-    for (int i = 0; i < cntc; i++)
+    // Exponentially distributed processing time per item (mean = mu_c ms)
+    Pacer pacer(ArrivalProcess(), mu_c, seed + global_id);
+    int idx = global_id - np;
+    int spinBudget = maxSpin;
+    vector<int> positions(batch);
+    vector<long long> enqueued(batch);
+    vector<int> itemLanes(batch);
+    long long activeSince = getTimestamp();
+    bool parked = false;
+    for (int i = 0; drainMode || i < cntc;)
     {
-        pthread_mutex_lock(&buffer_lock);
-        long long cs_entry = getTimestamp();
-        while (count_items == 0)
+        if (elastic && !waitUntilActive(idx, activeSince))
+        {
+            parked = true;
+            break;
+        }
+        // pop_n: one lock acquisition takes up to batch items
+        int want = drainMode ? batch : min(batch, cntc - i);
+        long long waitStart = chromeTraceNow();
+        consumerWaitingSince[idx].store(getTimestamp(), memory_order_relaxed);
+        long long cs_entry;
+        if constexpr (pollWait)
         {
-            // Buffer empty: release lock and wait briefly before retrying
-            pthread_mutex_unlock(&buffer_lock);
-            this_thread::sleep_for(chrono::milliseconds(1));
             pthread_mutex_lock(&buffer_lock);
+            cs_entry = getTimestamp();
+            while (count_items == 0 && !closed)
+            {
+                // Buffer empty: release lock and wait briefly before retrying
+                pthread_mutex_unlock(&buffer_lock);
+                this_thread::sleep_for(chrono::milliseconds(1));
+                pthread_mutex_lock(&buffer_lock);
+            }
+        }
+        else if (spinAcquire(spinBudget, notEmptyOrClosed))
+            cs_entry = getTimestamp();
+        else
+        {
+            pthread_mutex_lock(&buffer_lock);
+            cs_entry = getTimestamp();
+            // Buffer empty: sleep until a producer adds an item (or it is closed)
+            while (count_items == 0 && !closed)
+                pthread_cond_wait(&not_empty, &buffer_lock);
+        }
+        long long waitEnd = getTimestamp();
+        consumerIdleNs[idx].fetch_add(waitEnd - consumerWaitingSince[idx].load(memory_order_relaxed), memory_order_relaxed);
+        consumerWaitingSince[idx].store(0, memory_order_relaxed);
+        if (count_items == 0)
+        {
+            // Closed and drained
+            pthread_mutex_unlock(&buffer_lock);
+            break;
+        }
+        long long csStart = chromeTraceNow();
+        chromeTraceSpan(global_id, "wait", waitStart, csStart);
+        int k = min(want, count_items);
+        long long now = getTimestamp();
+        for (int j = 0; j < k; j++)
+        {
+            Item item;
+            size_t lane;
+            positions[j] = buffer->pop(now, item, lane);
+            enqueued[j] = item.enqueue_ns;
+            itemLanes[j] = item.lane;
         }
-        int pos = out_index;
-        int item = buffer[out_index];
-        out_index = (out_index + 1) % capacity;
-        count_items--;
+        count_items -= k;
         long long cs_exit = getTimestamp();
 
         {
@@ -166,17 +556,35 @@ void *consumer(void *arg)
             oss << "CONS_CS: " << global_id << " " << cs_entry << " " << cs_exit;
             logBuffers[global_id] += oss.str() + "\n";
         }
+        for (int j = 0; j < k; j++)
         {
             ostringstream oss;
-            oss << (i + 1) << "th item consumed by thread " << global_id
-                << " at " << cs_exit << " ms from buffer location " << pos;
+            oss << (i + j + 1) << "th item consumed by thread " << global_id << " at " << cs_exit << " ms from ";
+            if (numLanes > 1)
+                oss << "lane " << itemLanes[j] << " ";
+            oss << "buffer location " << positions[j];
             logBuffers[global_id] += oss.str() + "\n";
+            latencyHists[global_id - np].record(cs_exit - enqueued[j]);
+            laneHists[global_id - np][itemLanes[j]].record(cs_exit - enqueued[j]);
         }
+        chromeTraceSpan(global_id, "CS", csStart, chromeTraceNow());
         pthread_mutex_unlock(&buffer_lock);
+        if constexpr (!pollWait)
+        {
+            if (k > 1)
+                pthread_cond_broadcast(&not_full);
+            else
+                pthread_cond_signal(&not_full);
+        }
+        i += k;
 
-        double delay_ms = exp_dist(generator);
-        this_thread::sleep_for(chrono::milliseconds(static_cast<int>(delay_ms)));
+        // Process the items taken (one delay per item)
+        long long workStart = chromeTraceNow();
+        pacer.delay(k);
+        chromeTraceSpan(global_id, "work", workStart, chromeTraceNow());
     }
+    if (!parked)
+        consumerActiveNs[idx] += getTimestamp() - activeSince;
     pthread_exit(NULL);
     return NULL;
 }
@@ -185,9 +593,47 @@ int main(int argc, char *argv[])
 {
     if (argc < 2)
     {
-        cerr << "Usage: " << argv[0] << " inp-params.txt" << endl;
+        cerr << "Usage: " << argv[0] << " inp-params.txt [--spin=N] [--batch=B] [--lanes=P] [--lane-policy=strict|wrr] [--aging-ms=X] [--overflow=POLICY] [--push-timeout-ms=X] [--arrival=MODE] [--seed=N] [--drain] [--elastic=MIN:MAX]" << endl;
         return 1;
     }
+    for (int i = 2; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg.rfind("--spin=", 0) == 0)
+            maxSpin = max(0, stoi(arg.substr(7)));
+        else if (arg.rfind("--batch=", 0) == 0)
+            batch = max(1, stoi(arg.substr(8)));
+        else if (arg.rfind("--seed=", 0) == 0)
+            seed = static_cast<unsigned>(stoul(arg.substr(7)));
+        else if (arg.rfind("--lanes=", 0) == 0)
+            numLanes = min(max(1, stoi(arg.substr(8))), static_cast<int>(PriorityLanes<Item>::MAX_LANES));
+        else if (arg == "--lane-policy=strict")
+            lanePolicy = LanePolicy::Strict;
+        else if (arg == "--lane-policy=wrr")
+            lanePolicy = LanePolicy::WeightedRoundRobin;
+        else if (arg.rfind("--aging-ms=", 0) == 0)
+            agingMs = max(0.0, stod(arg.substr(11)));
+        else if (arg.rfind("--overflow=", 0) == 0 && parseOverflowPolicy(arg.substr(11), overflow))
+            drainMode = overflow != OverflowPolicy::Block || drainMode;
+        else if (arg.rfind("--push-timeout-ms=", 0) == 0)
+        {
+            pushTimeoutMs = max(0.0, stod(arg.substr(18)));
+            drainMode = pushTimeoutMs > 0 || drainMode;
+        }
+        else if (arg == "--drain")
+            drainMode = true;
+        else if (arg.rfind("--elastic=", 0) == 0 && arg.find(':') != string::npos)
+        {
+            elastic = drainMode = true;
+            minConsumers = max(1, stoi(arg.substr(10)));
+            maxConsumers = max(minConsumers, stoi(arg.substr(arg.find(':') + 1)));
+        }
+        else if (arg.rfind("--arrival=", 0) != 0 || !parseArrivalProcess(arg.substr(10), arrival))
+        {
+            cerr << "Usage: " << argv[0] << " inp-params.txt [--spin=N] [--batch=B] [--lanes=P] [--lane-policy=strict|wrr] [--aging-ms=X] [--overflow=POLICY] [--push-timeout-ms=X] [--arrival=MODE] [--seed=N] [--drain] [--elastic=MIN:MAX]" << endl;
+            return 1;
+        }
+    }
 
     ifstream inputFile(argv[1]);
     if (!inputFile)
@@ -198,12 +644,49 @@ int main(int argc, char *argv[])
     inputFile >> capacity >> np >> nc >> cntp >> cntc >> mu_p >> mu_c;
     inputFile.close();
 
-    buffer.resize(capacity, 0);
+    buffer = new PriorityLanes<Item>(numLanes, capacity, lanePolicy, static_cast<long long>(agingMs * 1e6));
 
     pthread_mutex_init(&buffer_lock, NULL);
+    // Producers with a push timeout wait on not_full with a CLOCK_MONOTONIC deadline
+    pthread_condattr_t monotonic;
+    pthread_condattr_init(&monotonic);
+    pthread_condattr_setclock(&monotonic, CLOCK_MONOTONIC);
+    pthread_cond_init(&not_full, &monotonic);
+    pthread_condattr_destroy(&monotonic);
+    pthread_cond_init(&not_empty, NULL);
+    pthread_mutex_init(&pool_lock, NULL);
+    pthread_cond_init(&unparked, NULL);
+
+    // An elastic pool starts with nc active consumers and has maxConsumers threads
+    if (elastic)
+    {
+        targetConsumers = min(max(nc, minConsumers), maxConsumers);
+        poolPeak = targetConsumers;
+        nc = maxConsumers;
+    }
+    else
+        targetConsumers = nc;
+    consumerIdleNs = vector<atomic<long long>>(nc);
+    consumerWaitingSince = vector<atomic<long long>>(nc);
+    consumerActiveNs.assign(nc, 0);
 
     int totalThreads = np + nc;
     logBuffers.resize(totalThreads, "");
+    latencyHists.assign(nc, LatencyHistogram());
+    laneHists.assign(nc, vector<LatencyHistogram>(numLanes));
+    rejectedItems.assign(np, 0);
+    droppedNewItems.assign(np, 0);
+    droppedOldItems.assign(np, 0);
+    timedOutItems.assign(np, 0);
+
+    if constexpr (chromeTraceEnabled)
+    {
+        chromeTrace.init(totalThreads);
+        for (int i = 0; i < np; i++)
+            chromeTrace.nameThread(i, "Producer " + to_string(i));
+        for (int i = 0; i < nc; i++)
+            chromeTrace.nameThread(np + i, "Consumer " + to_string(i));
+    }
 
     base_time = steady_clock::now();
 
@@ -231,23 +714,104 @@ int main(int argc, char *argv[])
         }
     }
 
+    pthread_t supervisorThread;
+    if (elastic)
+    {
+        supervising = true;
+        if (pthread_create(&supervisorThread, NULL, supervisor, NULL) != 0)
+        {
+            cerr << "Error: Unable to create the supervisor thread" << endl;
+            return 1;
+        }
+    }
+
     for (int i = 0; i < np; i++)
     {
         pthread_join(producerThreads[i], NULL);
     }
+    if (drainMode)
+    {
+        // Every item is in; consumers finish what is left and then stop
+        pthread_mutex_lock(&buffer_lock);
+        closed = true;
+        pthread_mutex_unlock(&buffer_lock);
+        pthread_cond_broadcast(&not_empty);
+    }
+    if (elastic)
+    {
+        supervising = false;
+        pthread_join(supervisorThread, NULL);
+        pthread_mutex_lock(&pool_lock);
+        poolClosed = true;
+        pthread_mutex_unlock(&pool_lock);
+        pthread_cond_broadcast(&unparked);
+    }
     for (int i = 0; i < nc; i++)
     {
         pthread_join(consumerThreads[i], NULL);
     }
+    long long elapsed_ns = getTimestamp();
 
     long long totalDuration = duration_cast<milliseconds>(steady_clock::now() - base_time).count();
+    if constexpr (chromeTraceEnabled)
+        chromeTrace.write("trace_locks.json");
     ostringstream oss;
     oss << "Total execution time: " << totalDuration << " ms";
     logBuffers[0] += oss.str() + "\n";
 
     parseAndWriteLogs(logBuffers);
 
+    LatencyHistogram latency;
+    for (const LatencyHistogram &h : latencyHists)
+        latency.merge(h);
+    for (const string &line : latency.reportLines())
+        cout << line << endl;
+    cout << "Throughput: " << to_string(latency.count() * 1e9 / max(elapsed_ns, 1LL)) << " items/s" << endl;
+    if (overflow != OverflowPolicy::Block || pushTimeoutMs > 0)
+    {
+        long long rejected = 0, droppedNew = 0, droppedOld = 0, timedOut = 0;
+        for (int p = 0; p < np; p++)
+        {
+            rejected += rejectedItems[p];
+            droppedNew += droppedNewItems[p];
+            droppedOld += droppedOldItems[p];
+            timedOut += timedOutItems[p];
+        }
+        cout << "Items offered: " << np * cntp << ", rejected: " << rejected << ", dropped newest: " << droppedNew
+             << ", dropped oldest: " << droppedOld << ", timed out: " << timedOut << endl;
+    }
+    if (numLanes > 1)
+    {
+        for (int l = 0; l < numLanes; l++)
+        {
+            LatencyHistogram lane;
+            for (const vector<LatencyHistogram> &hists : laneHists)
+                lane.merge(hists[l]);
+            cout << "Lane " << l << " queueing latency: samples " << lane.count() << ", p50 " << lane.percentile(50)
+                 << " ns, p99 " << lane.percentile(99) << " ns, max " << lane.max() << " ns" << endl;
+        }
+        cout << "Aged pops: " << buffer->agedPops() << endl;
+    }
+
+    if (drainMode)
+    {
+        long long activeNs = 0;
+        for (long long ns : consumerActiveNs)
+            activeNs += ns;
+        double threadSeconds = activeNs / 1e9;
+        cout << "Consumer thread-seconds: " << to_string(threadSeconds) << endl;
+        cout << "Items per consumer thread-second: " << to_string(latency.count() / max(threadSeconds, 1e-9)) << endl;
+        if (elastic)
+            cout << "Elastic pool: " << minConsumers << " to " << maxConsumers << " consumers, " << poolAdds
+                 << " added, " << poolParks << " parked, peak " << poolPeak << endl;
+    }
+
     pthread_mutex_destroy(&buffer_lock);
+    pthread_cond_destroy(&not_full);
+    pthread_cond_destroy(&not_empty);
+    pthread_mutex_destroy(&pool_lock);
+    pthread_cond_destroy(&unparked);
+    delete buffer;
 
     return 0;
 }
@@ -0,0 +1,321 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <pthread.h>
+#include <cstdlib>
+#include <algorithm>
+#include "chrome_trace.h"
+#include "mpmc_ring.h"
+#include "latency_histogram.h"
+#include "pacing.h"
+
+using namespace std;
+using namespace std::chrono;
+
+int capacity, np, nc, cntp, cntc;
+double mu_p, mu_c;
+// Items carry the time they were put in the ring
+struct Item
+{
+    int id;
+    long long enqueue_ns;
+};
+MpmcRing<Item> *ring = nullptr;
+
+// How producers space their items (--arrival=exp|const|bursty[:ON_MS:OFF_MS])
+ArrivalProcess arrival;
+
+// Seed of the delay generators, random unless --seed=N; thread i uses seed + i
+unsigned seed = random_device{}();
+
+// Queueing latency (dequeue minus enqueue time) recorded by each consumer
+vector<LatencyHistogram> latencyHists;
+
+vector<string> logBuffers;
+
+steady_clock::time_point base_time;
+
+void writeOutputToFile(const string &output)
+{
+    ofstream outFile("output_ring.txt", ios::app);
+    if (outFile)
+        outFile << output << endl;
+    else
+        cout << "Error: Could not open output file." << endl;
+    outFile.close();
+}
+
+vector<string> splitByNewline(const string &buffer)
+{
+    vector<string> lines;
+    size_t start = 0, end;
+    while ((end = buffer.find('\n', start)) != string::npos)
+    {
+        string line = buffer.substr(start, end - start);
+        if (!line.empty())
+            lines.push_back(line);
+        start = end + 1;
+    }
+    if (start < buffer.size())
+        lines.push_back(buffer.substr(start));
+    return lines;
+}
+
+void parseAndWriteLogs(const vector<string> &buffers)
+{
+    vector<pair<long long, string>> logs;
+    for (const string &buffer : buffers)
+    {
+        vector<string> lines = splitByNewline(buffer);
+        for (const string &line : lines)
+        {
+            size_t lastSpace = line.find_last_of(' ');
+            if (lastSpace != string::npos)
+            {
+                string logMessage = line.substr(0, lastSpace);
+                string lastToken = line.substr(lastSpace + 1);
+                try
+                {
+                    long long timestamp = stoll(lastToken);
+                    logs.emplace_back(timestamp, logMessage);
+                }
+                catch (const std::invalid_argument &e)
+                {
+                    // Skip lines where the last token is not a number (e.g., total execution time line)
+                    continue;
+                }
+            }
+        }
+    }
+    sort(logs.begin(), logs.end(), [](const pair<long long, string> &a, const pair<long long, string> &b)
+         { return a.first < b.first; });
+    // Clear the output file first
+    ofstream clearFile("output_ring.txt", ios::out);
+    clearFile.close();
+    for (const auto &log : logs)
+    {
+        writeOutputToFile(log.second + " " + to_string(log.first));
+    }
+}
+
+long long getTimestamp()
+{
+    auto now = steady_clock::now();
+    return duration_cast<nanoseconds>(now - base_time).count();
+}
+
+// Nothing can be done until another thread moves the ring, so spin briefly
+// by yielding and then sleep in short steps instead of burning the CPU
+void backoff(int &spins)
+{
+    if (spins < 64)
+    {
+        spins++;
+        this_thread::yield();
+    }
+    else
+        this_thread::sleep_for(chrono::microseconds(50));
+}
+
+void *producer(void *arg)
+{
+    int global_id = *(int *)arg;
+    // Open-loop arrivals (--arrival=, exponential by default)
+    Pacer pacer(arrival, mu_p, seed + global_id);
+
+    for (int i = 0; i < cntp; i++)
+    {
+        Item item{global_id * 1000 + i, 0};
+
+        long long waitStart = chromeTraceNow();
+        long long cs_entry, csStart;
+        size_t pos;
+        int spins = 0;
+        while (true)
+        {
+            cs_entry = getTimestamp();
+            csStart = chromeTraceNow();
+            item.enqueue_ns = cs_entry;
+            if (ring->tryPush(item, pos))
+                break;
+            // Buffer full: back off and retry
+            backoff(spins);
+        }
+        long long cs_exit = getTimestamp();
+        chromeTraceSpan(global_id, "wait", waitStart, csStart);
+        chromeTraceSpan(global_id, "CS", csStart, chromeTraceNow());
+        {
+            ostringstream oss;
+            oss << "PROD_CS: " << global_id << " " << cs_entry << " " << cs_exit;
+            logBuffers[global_id] += oss.str() + "\n";
+        }
+        {
+            ostringstream oss;
+            oss << (i + 1) << "th item produced by thread " << global_id
+                << " at " << cs_exit << " ms into buffer location " << pos;
+            logBuffers[global_id] += oss.str() + "\n";
+        }
+
+        long long workStart = chromeTraceNow();
+        pacer.nextArrival();
+        chromeTraceSpan(global_id, "work", workStart, chromeTraceNow());
+    }
+    pthread_exit(NULL);
+    return NULL;
+}
+
+
+void *consumer(void *arg)
+{
+    int global_id = *(int *)arg;
+    // Exponentially distributed processing time per item (mean = mu_c ms)
+    Pacer pacer(ArrivalProcess(), mu_c, seed + global_id);
+    for (int i = 0; i < cntc; i++)
+    {
+        long long waitStart = chromeTraceNow();
+        long long cs_entry, csStart;
+        size_t pos;
+        Item item;
+        int spins = 0;
+        while (true)
+        {
+            cs_entry = getTimestamp();
+            csStart = chromeTraceNow();
+            if (ring->tryPop(item, pos))
+                break;
+            // Buffer empty: back off and retry
+            backoff(spins);
+        }
+        long long cs_exit = getTimestamp();
+        chromeTraceSpan(global_id, "wait", waitStart, csStart);
+        chromeTraceSpan(global_id, "CS", csStart, chromeTraceNow());
+
+        {
+            ostringstream oss;
+            oss << "CONS_CS: " << global_id << " " << cs_entry << " " << cs_exit;
+            logBuffers[global_id] += oss.str() + "\n";
+        }
+        {
+            ostringstream oss;
+            oss << (i + 1) << "th item consumed by thread " << global_id
+                << " at " << cs_exit << " ms from buffer location " << pos;
+            logBuffers[global_id] += oss.str() + "\n";
+        }
+        latencyHists[global_id - np].record(cs_exit - item.enqueue_ns);
+
+        long long workStart = chromeTraceNow();
+        pacer.delay();
+        chromeTraceSpan(global_id, "work", workStart, chromeTraceNow());
+    }
+    pthread_exit(NULL);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        cerr << "Usage: " << argv[0] << " inp-params.txt [--arrival=MODE] [--seed=N]" << endl;
+        return 1;
+    }
+    for (int i = 2; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg.rfind("--seed=", 0) == 0)
+            seed = static_cast<unsigned>(stoul(arg.substr(7)));
+        else if (arg.rfind("--arrival=", 0) != 0 || !parseArrivalProcess(arg.substr(10), arrival))
+        {
+            cerr << "Usage: " << argv[0] << " inp-params.txt [--arrival=MODE] [--seed=N]" << endl;
+            return 1;
+        }
+    }
+
+    ifstream inputFile(argv[1]);
+    if (!inputFile)
+    {
+        cerr << "Error: Cannot open input file " << argv[1] << endl;
+        return 1;
+    }
+    inputFile >> capacity >> np >> nc >> cntp >> cntc >> mu_p >> mu_c;
+    inputFile.close();
+
+    if (capacity < 2)
+    {
+        cerr << "Error: the ring needs a capacity of at least 2" << endl;
+        return 1;
+    }
+    ring = new MpmcRing<Item>(capacity);
+
+    int totalThreads = np + nc;
+    logBuffers.resize(totalThreads, "");
+    latencyHists.assign(nc, LatencyHistogram());
+
+    if constexpr (chromeTraceEnabled)
+    {
+        chromeTrace.init(totalThreads);
+        for (int i = 0; i < np; i++)
+            chromeTrace.nameThread(i, "Producer " + to_string(i));
+        for (int i = 0; i < nc; i++)
+            chromeTrace.nameThread(np + i, "Consumer " + to_string(i));
+    }
+
+    base_time = steady_clock::now();
+
+    vector<pthread_t> producerThreads(np);
+    vector<pthread_t> consumerThreads(nc);
+    vector<int> producer_global_ids(np), consumer_global_ids(nc);
+
+    for (int i = 0; i < np; i++)
+    {
+        producer_global_ids[i] = i;
+        if (pthread_create(&producerThreads[i], NULL, producer, &producer_global_ids[i]) != 0)
+        {
+            cerr << "Error: Unable to create producer thread " << i << endl;
+            return 1;
+        }
+    }
+
+    for (int i = 0; i < nc; i++)
+    {
+        consumer_global_ids[i] = i + np;
+        if (pthread_create(&consumerThreads[i], NULL, consumer, &consumer_global_ids[i]) != 0)
+        {
+            cerr << "Error: Unable to create consumer thread " << i << endl;
+            return 1;
+        }
+    }
+
+    for (int i = 0; i < np; i++)
+    {
+        pthread_join(producerThreads[i], NULL);
+    }
+    for (int i = 0; i < nc; i++)
+    {
+        pthread_join(consumerThreads[i], NULL);
+    }
+    long long elapsed_ns = getTimestamp();
+
+    long long totalDuration = duration_cast<milliseconds>(steady_clock::now() - base_time).count();
+    if constexpr (chromeTraceEnabled)
+        chromeTrace.write("trace_ring.json");
+    ostringstream oss;
+    oss << "Total execution time: " << totalDuration << " ms";
+    logBuffers[0] += oss.str() + "\n";
+
+    parseAndWriteLogs(logBuffers);
+
+    LatencyHistogram latency;
+    for (const LatencyHistogram &h : latencyHists)
+        latency.merge(h);
+    for (const string &line : latency.reportLines())
+        cout << line << endl;
+    cout << "Throughput: " << to_string(latency.count() * 1e9 / max(elapsed_ns, 1LL)) << " items/s" << endl;
+
+    delete ring;
+
+    return 0;
+}
@@ -9,24 +9,96 @@
 #include <pthread.h>
 #include <cstdlib>
 #include <algorithm>
+#include "chrome_trace.h"
+#include "latency_histogram.h"
+#include "pacing.h"
+#include "spsc_ring.h"
+#include "elimination_array.h"
+#include "log_drain.h"
+#include "live_metrics.h"
+#include "fast_semaphore.h"
+#include "bounded_buffer.h"
 
 using namespace std;
 using namespace std::chrono;
 
 int capacity, np, nc, cntp, cntc;
 double mu_p, mu_c; 
-vector<int> buffer;
-int in_index = 0, out_index = 0;
+// Items carry the time they were put in the buffer
+struct Item
+{
+    int id;
+    long long enqueue_ns;
+};
+
+// Queueing latency (dequeue minus enqueue time) recorded by each consumer
+vector<LatencyHistogram> latencyHists;
+
+// -DFAST_SEM swaps sem_t for the futex-based FastSemaphore (fast_semaphore.h);
+// the buffer's sem_* calls resolve to its overloads
+#ifdef FAST_SEM
+typedef FastSemaphore semaphore_t;
+#else
+typedef sem_t semaphore_t;
+#endif
+
+// The ring with its empty/full/mutex semaphores (bounded_buffer.h)
+typedef BoundedBuffer<Item, BasicSemaphoreSync<semaphore_t>> ItemBuffer;
+ItemBuffer *buffer = nullptr;
+
+// With one producer and one consumer the semaphores are replaced by an SPSC
+// ring (spsc_ring.h) unless --general is given
+SpscRing<Item> *spsc = nullptr;
+
+// Items moved per synchronization round trip (--batch=B, default 1)
+int batch = 1;
+
+// With --eliminate a producer hands its item straight to a consumer waiting
+// on an empty buffer (elimination_array.h); consumer i parks in slot i
+EliminationArray<Item> *elimination = nullptr;
+// Items each consumer received through the elimination array
+vector<long long> eliminatedItems;
+
+// How producers space their items (--arrival=exp|const|bursty[:ON_MS:OFF_MS])
+ArrivalProcess arrival;
 
-sem_t sem_empty; 
-sem_t sem_full;  
-sem_t sem_mutex; 
+// Seed of the delay generators, random unless --seed=N; thread i uses seed + i
+unsigned seed = random_device{}();
 
 
 vector<string> logBuffers;
 
 steady_clock::time_point base_time;
 
+// One line of output_sems.txt in binary form; time (cs_exit) orders the lines
+struct LogRecord
+{
+    long long time;
+    enum Kind
+    {
+        ProdCS,
+        ConsCS,
+        Produced,
+        Consumed,
+        ProducedToSlot,
+        ConsumedFromSlot
+    } kind;
+    int thread;
+    long long n;     // item number of the thread (item lines)
+    long long value; // cs_entry (CS lines), buffer location or elimination slot
+};
+
+// With --stream-log the lines go through a LogDrain (log_drain.h) and are
+// written while the run goes on, ordered by time, in fixed memory. Without it
+// they are collected in logBuffers and sorted and written at exit.
+LogDrain<LogRecord> *logDrain = nullptr;
+const size_t LOG_RING_RECORDS = 4096;
+
+// With --metrics=SINK a sampler thread publishes depth, rates, blocked
+// threads and latency every --metrics-interval-ms (live_metrics.h); the
+// threads only update their own relaxed counters
+LiveMetrics *metrics = nullptr;
+
 
 void writeOutputToFile(const string &output)
 {
@@ -97,43 +169,156 @@ long long getTimestamp()
     return duration_cast<nanoseconds>(now - base_time).count();
 }
 
-// Producer thread function
-void *producer(void *arg)
+void writeLogRecord(ostream &out, const LogRecord &r)
 {
-    int global_id = *(int *)arg; 
-    // Set up a random generator for exponential delay (mean = mu_p ms)
-    default_random_engine generator(random_device{}());
-    exponential_distribution<double> exp_dist(1.0 / mu_p); // mean delay in ms
+    switch (r.kind)
+    {
+    case LogRecord::ProdCS:
+        out << "PROD_CS: " << r.thread << " " << r.value << " " << r.time;
+        break;
+    case LogRecord::ConsCS:
+        out << "CONS_CS: " << r.thread << " " << r.value << " " << r.time;
+        break;
+    case LogRecord::Produced:
+        out << r.n << "th item produced by thread " << r.thread << " at " << r.time << " ms into buffer location " << r.value;
+        break;
+    case LogRecord::Consumed:
+        out << r.n << "th item consumed by thread " << r.thread << " at " << r.time << " ms from buffer location " << r.value;
+        break;
+    case LogRecord::ProducedToSlot:
+        out << r.n << "th item produced by thread " << r.thread << " at " << r.time << " ms into elimination slot " << r.value;
+        break;
+    case LogRecord::ConsumedFromSlot:
+        out << r.n << "th item consumed by thread " << r.thread << " at " << r.time << " ms from elimination slot " << r.value;
+        break;
+    }
+}
 
-    for (int i = 0; i < cntp; i++)
+// A thread logs a group of lines as logBegin, then its timestamp, then
+// logEvent for each line, then logEnd (see log_drain.h)
+void logBegin(int thread)
+{
+    if (logDrain)
+        logDrain->begin(thread);
+}
+
+void logEvent(const LogRecord &r)
+{
+    if (logDrain)
+        logDrain->push(r.thread, r);
+    else
     {
-        int item = global_id * 1000 + i; 
+        ostringstream oss;
+        writeLogRecord(oss, r);
+        logBuffers[r.thread] += oss.str() + "\n";
+    }
+}
 
-        sem_wait(&sem_empty);
-        long long cs_entry = getTimestamp();
-        sem_wait(&sem_mutex);
-        int pos = in_index;
-        buffer[in_index] = item;
-        in_index = (in_index + 1) % capacity;
-        long long cs_exit = getTimestamp();
+void logEnd(int thread)
+{
+    if (logDrain)
+        logDrain->end(thread);
+}
+
+// Consumer side of --eliminate: claims an item in the buffer (a sem_full
+// token; returns false) or, when the buffer is empty, parks until a producer
+// hands over an item (returns true with it)
+bool waitFullOrHandOff(size_t slot, Item &item)
+{
+    for (;;)
+    {
+        if (buffer->tryReservePop(1))
+            return false;
+        elimination->park(slot);
+        if (buffer->tryReservePop(1))
         {
-            ostringstream oss;
-            oss << "PROD_CS: " << global_id << " " << cs_entry << " " << cs_exit;
-            logBuffers[global_id] += oss.str() + "\n";
+            if (elimination->withdraw(slot))
+                return false;
+            // A producer took the slot first; its item or nudge is on the way.
+            // Put the token back and pass it on to another parked consumer,
+            // which may have been nudged for it and gone back to sleep.
+            buffer->unreservePop();
+            elimination->nudge(slot + 1);
         }
+        if (elimination->wait(slot, item))
+            return true;
+        // Nudged: an item went into the buffer meanwhile, look again
+    }
+}
+
+// Producer thread function
+void *producer(void *arg)
+{
+    int global_id = *(int *)arg; 
+    // Open-loop arrivals (--arrival=, exponential by default)
+    Pacer pacer(arrival, mu_p, seed + global_id);
+    vector<int> positions(batch);
+
+    // Items are produced in bursts of up to batch items, then the thread
+    // sleeps for the sum of their delays, so cntp and the mean rate are kept
+    for (int i = 0; i < cntp;)
+    {
+        int burst = min(batch, cntp - i);
+        int done = 0;
+        while (done < burst)
         {
-            ostringstream oss;
-            oss << (i + 1) << "th item produced by thread " << global_id
-                << " at " << cs_exit << " ms into buffer location " << pos;
-            logBuffers[global_id] += oss.str() + "\n";
+            if (elimination)
+            {
+                // A consumer waiting on an empty buffer takes the item directly
+                long long cs_entry = getTimestamp();
+                long long csStart = chromeTraceNow();
+                size_t slot;
+                if (elimination->tryHandOff({global_id * 1000 + i + done, cs_entry}, global_id, slot))
+                {
+                    logBegin(global_id);
+                    long long cs_exit = getTimestamp();
+                    chromeTraceSpan(global_id, "handoff", csStart, chromeTraceNow());
+                    logEvent({cs_exit, LogRecord::ProdCS, global_id, 0, cs_entry});
+                    logEvent({cs_exit, LogRecord::ProducedToSlot, global_id, i + done + 1, static_cast<long long>(slot)});
+                    logEnd(global_id);
+                    if (metrics)
+                        metrics->enqueued(global_id);
+                    done++;
+                    continue;
+                }
+            }
+            // push_n: block for one free slot, then grab as many more of the
+            // burst as are free without blocking, and fill them all under one
+            // pass through sem_mutex
+            long long waitStart = chromeTraceNow();
+            if (metrics)
+                metrics->blocked(global_id, true);
+            int k = buffer->reservePush(burst - done);
+            if (metrics)
+                metrics->blocked(global_id, false);
+            long long cs_entry = getTimestamp();
+            {
+                ItemBuffer::PushBatch slots(*buffer, k);
+                long long csStart = chromeTraceNow();
+                chromeTraceSpan(global_id, "wait", waitStart, csStart);
+                for (int j = 0; j < k; j++)
+                    positions[j] = slots.emplace(Item{global_id * 1000 + i + done + j, getTimestamp()});
+                logBegin(global_id);
+                long long cs_exit = getTimestamp();
+                logEvent({cs_exit, LogRecord::ProdCS, global_id, 0, cs_entry});
+                for (int j = 0; j < k; j++)
+                    logEvent({cs_exit, LogRecord::Produced, global_id, i + done + j + 1, positions[j]});
+                logEnd(global_id);
+                if (metrics)
+                    metrics->enqueued(global_id, k);
+
+                chromeTraceSpan(global_id, "CS", csStart, chromeTraceNow());
+            }
+            if (elimination)
+                elimination->nudge(global_id);
+            done += k;
         }
+        i += burst;
 
-        sem_post(&sem_mutex);
-        sem_post(&sem_full);
-
-        // Sleep for an exponentially distributed delay
-        double delay_ms = exp_dist(generator);
-        this_thread::sleep_for(milliseconds(static_cast<int>(delay_ms)));
+        // Wait for the arrival of the next burst (one gap per item)
+        long long workStart = chromeTraceNow();
+        pacer.nextArrival(burst);
+        chromeTraceSpan(global_id, "work", workStart, chromeTraceNow());
     }
     pthread_exit(NULL);
     return NULL;
@@ -143,52 +328,223 @@ void *producer(void *arg)
 void *consumer(void *arg)
 {
     int global_id = *(int *)arg; 
-    // Set up a random generator for exponential delay (mean = mu_c ms)
-    default_random_engine generator(random_device{}());
-    exponential_distribution<double> exp_dist(1.0 / mu_c);
+    // Exponentially distributed processing time per item (mean = mu_c ms)
+    Pacer pacer(ArrivalProcess(), mu_c, seed + global_id);
+    vector<int> positions(batch);
+    vector<long long> enqueued(batch);
 
-    for (int i = 0; i < cntc; i++)
+    for (int i = 0; i < cntc;)
     {
-        sem_wait(&sem_full);
+        // pop_n: block for one item, then take as many more as are ready
+        // without blocking, up to the batch size
+        int want = min(batch, cntc - i);
+        long long waitStart = chromeTraceNow();
+        Item handed;
+        if (metrics)
+            metrics->blocked(global_id, true);
+        bool wasHanded = elimination && waitFullOrHandOff(global_id - np, handed);
+        // --eliminate moves single items, so waitFullOrHandOff claims all of them
+        int k = elimination ? 1 : buffer->reservePop(want);
+        if (metrics)
+            metrics->blocked(global_id, false);
+        if (wasHanded)
+        {
+            logBegin(global_id);
+            long long cs_exit = getTimestamp();
+            chromeTraceSpan(global_id, "wait", waitStart, chromeTraceNow());
+            logEvent({cs_exit, LogRecord::ConsCS, global_id, 0, cs_exit});
+            logEvent({cs_exit, LogRecord::ConsumedFromSlot, global_id, i + 1, global_id - np});
+            logEnd(global_id);
+            latencyHists[global_id - np].record(cs_exit - handed.enqueue_ns);
+            if (metrics)
+                metrics->dequeued(global_id, cs_exit - handed.enqueue_ns);
+            eliminatedItems[global_id - np]++;
+            i++;
+
+            long long workStart = chromeTraceNow();
+            pacer.delay();
+            chromeTraceSpan(global_id, "work", workStart, chromeTraceNow());
+            continue;
+        }
         long long cs_entry = getTimestamp();
-        sem_wait(&sem_mutex);
+        {
+            ItemBuffer::PopBatch items(*buffer, k);
+            long long csStart = chromeTraceNow();
+            chromeTraceSpan(global_id, "wait", waitStart, csStart);
 
-        int pos = out_index;
-        int item = buffer[out_index];
-        out_index = (out_index + 1) % capacity;
+            for (int j = 0; j < k; j++)
+            {
+                Item item;
+                positions[j] = items.popInto(item);
+                enqueued[j] = item.enqueue_ns;
+            }
 
-        long long cs_exit = getTimestamp();
+            logBegin(global_id);
+            long long cs_exit = getTimestamp();
+            logEvent({cs_exit, LogRecord::ConsCS, global_id, 0, cs_entry});
+            for (int j = 0; j < k; j++)
+            {
+                logEvent({cs_exit, LogRecord::Consumed, global_id, i + j + 1, positions[j]});
+                latencyHists[global_id - np].record(cs_exit - enqueued[j]);
+                if (metrics)
+                    metrics->dequeued(global_id, cs_exit - enqueued[j]);
+            }
+            logEnd(global_id);
+
+            chromeTraceSpan(global_id, "CS", csStart, chromeTraceNow());
+        }
+        i += k;
+
+        // Process the items taken (one delay per item)
+        long long workStart = chromeTraceNow();
+        pacer.delay(k);
+        chromeTraceSpan(global_id, "work", workStart, chromeTraceNow());
+    }
+    pthread_exit(NULL);
+    return NULL;
+}
+
+// The SPSC ring never blocks, so a thread that finds it full (or empty) yields
+// for a while and then sleeps in short steps until the other side catches up
+void backoff(int &spins)
+{
+    if (spins < 64)
+    {
+        spins++;
+        this_thread::yield();
+    }
+    else
+        this_thread::sleep_for(microseconds(50));
+}
+
+// Producer for np == nc == 1: no semaphores, same log lines
+void *spscProducer(void *arg)
+{
+    int global_id = *(int *)arg;
+    // Open-loop arrivals (--arrival=, exponential by default)
+    Pacer pacer(arrival, mu_p, seed + global_id);
+
+    for (int i = 0; i < cntp; i++)
+    {
+        Item item{global_id * 1000 + i, 0};
+
+        long long waitStart = chromeTraceNow();
+        long long cs_entry, csStart;
+        size_t pos;
+        int spins = 0;
+        while (true)
         {
-            ostringstream oss;
-            oss << "CONS_CS: " << global_id << " " << cs_entry << " " << cs_exit;
-            logBuffers[global_id] += oss.str() + "\n";
+            cs_entry = getTimestamp();
+            csStart = chromeTraceNow();
+            item.enqueue_ns = cs_entry;
+            if (spsc->tryPush(item, pos))
+                break;
+            if (metrics && spins == 0)
+                metrics->blocked(global_id, true);
+            backoff(spins);
         }
+        if (metrics)
         {
-            ostringstream oss;
-            oss << (i + 1) << "th item consumed by thread " << global_id
-                << " at " << cs_exit << " ms from buffer location " << pos;
-            logBuffers[global_id] += oss.str() + "\n";
+            metrics->blocked(global_id, false);
+            metrics->enqueued(global_id);
         }
+        logBegin(global_id);
+        long long cs_exit = getTimestamp();
+        chromeTraceSpan(global_id, "wait", waitStart, csStart);
+        chromeTraceSpan(global_id, "CS", csStart, chromeTraceNow());
+        logEvent({cs_exit, LogRecord::ProdCS, global_id, 0, cs_entry});
+        logEvent({cs_exit, LogRecord::Produced, global_id, i + 1, static_cast<long long>(pos)});
+        logEnd(global_id);
+
+        long long workStart = chromeTraceNow();
+        pacer.nextArrival();
+        chromeTraceSpan(global_id, "work", workStart, chromeTraceNow());
+    }
+    pthread_exit(NULL);
+    return NULL;
+}
 
-        sem_post(&sem_mutex);
-        sem_post(&sem_empty);
+// Consumer for np == nc == 1
+void *spscConsumer(void *arg)
+{
+    int global_id = *(int *)arg;
+    // Exponentially distributed processing time per item (mean = mu_c ms)
+    Pacer pacer(ArrivalProcess(), mu_c, seed + global_id);
 
-        // Sleep for an exponentially distributed delay
-        double delay_ms = exp_dist(generator);
-        this_thread::sleep_for(milliseconds(static_cast<int>(delay_ms)));
+    for (int i = 0; i < cntc; i++)
+    {
+        long long waitStart = chromeTraceNow();
+        long long cs_entry, csStart;
+        size_t pos;
+        Item item;
+        int spins = 0;
+        while (true)
+        {
+            cs_entry = getTimestamp();
+            csStart = chromeTraceNow();
+            if (spsc->tryPop(item, pos))
+                break;
+            if (metrics && spins == 0)
+                metrics->blocked(global_id, true);
+            backoff(spins);
+        }
+        logBegin(global_id);
+        long long cs_exit = getTimestamp();
+        chromeTraceSpan(global_id, "wait", waitStart, csStart);
+        chromeTraceSpan(global_id, "CS", csStart, chromeTraceNow());
+        logEvent({cs_exit, LogRecord::ConsCS, global_id, 0, cs_entry});
+        logEvent({cs_exit, LogRecord::Consumed, global_id, i + 1, static_cast<long long>(pos)});
+        logEnd(global_id);
+        latencyHists[global_id - np].record(cs_exit - item.enqueue_ns);
+        if (metrics)
+        {
+            metrics->blocked(global_id, false);
+            metrics->dequeued(global_id, cs_exit - item.enqueue_ns);
+        }
+
+        long long workStart = chromeTraceNow();
+        pacer.delay();
+        chromeTraceSpan(global_id, "work", workStart, chromeTraceNow());
     }
     pthread_exit(NULL);
     return NULL;
 }
 
-
 int main(int argc, char *argv[])
 {
     if (argc < 2)
     {
-        cerr << "Usage: " << argv[0] << " inp-params.txt" << endl;
+        cerr << "Usage: " << argv[0] << " inp-params.txt [--general] [--batch=B] [--eliminate] [--stream-log] [--metrics=PATH|unix:PATH] [--metrics-interval-ms=N] [--arrival=MODE] [--seed=N]" << endl;
         return 1;
     }
+    bool forceGeneral = false;
+    bool eliminate = false;
+    bool streamLog = false;
+    string metricsSink;
+    long long metricsIntervalMs = 100;
+    for (int i = 2; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--general")
+            forceGeneral = true;
+        else if (arg == "--eliminate")
+            eliminate = true;
+        else if (arg == "--stream-log")
+            streamLog = true;
+        else if (arg.rfind("--metrics=", 0) == 0)
+            metricsSink = arg.substr(10);
+        else if (arg.rfind("--metrics-interval-ms=", 0) == 0)
+            metricsIntervalMs = max(1LL, stoll(arg.substr(22)));
+        else if (arg.rfind("--batch=", 0) == 0)
+            batch = max(1, stoi(arg.substr(8)));
+        else if (arg.rfind("--seed=", 0) == 0)
+            seed = static_cast<unsigned>(stoul(arg.substr(7)));
+        else if (arg.rfind("--arrival=", 0) != 0 || !parseArrivalProcess(arg.substr(10), arrival))
+        {
+            cerr << "Usage: " << argv[0] << " inp-params.txt [--general] [--batch=B] [--eliminate] [--stream-log] [--metrics=PATH|unix:PATH] [--metrics-interval-ms=N] [--arrival=MODE] [--seed=N]" << endl;
+            return 1;
+        }
+    }
 
     ifstream inputFile(argv[1]);
     if (!inputFile)
@@ -199,16 +555,59 @@ int main(int argc, char *argv[])
     inputFile >> capacity >> np >> nc >> cntp >> cntc >> mu_p >> mu_c;
     inputFile.close();
 
-    buffer.resize(capacity, 0);
+    if (eliminate && batch > 1)
+    {
+        cerr << "Error: --eliminate hands over single items and cannot be combined with --batch" << endl;
+        return 1;
+    }
 
-    sem_init(&sem_empty, 0, capacity);
-    sem_init(&sem_full, 0, 0);
-    sem_init(&sem_mutex, 0, 1);
+    buffer = new ItemBuffer(capacity);
+    if (eliminate)
+        elimination = new EliminationArray<Item>(nc);
+    else if (np == 1 && nc == 1 && !forceGeneral && batch == 1 && capacity > 0)
+        spsc = new SpscRing<Item>(capacity);
+    void *(*producerFn)(void *) = spsc ? spscProducer : producer;
+    void *(*consumerFn)(void *) = spsc ? spscConsumer : consumer;
 
     int totalThreads = np + nc;
     logBuffers.resize(totalThreads, "");
+    latencyHists.assign(nc, LatencyHistogram());
+    eliminatedItems.assign(nc, 0);
+
+    if constexpr (chromeTraceEnabled)
+    {
+        chromeTrace.init(totalThreads);
+        for (int i = 0; i < np; i++)
+            chromeTrace.nameThread(i, "Producer " + to_string(i));
+        for (int i = 0; i < nc; i++)
+            chromeTrace.nameThread(np + i, "Consumer " + to_string(i));
+    }
 
     base_time = steady_clock::now();
+    if (streamLog)
+    {
+        try
+        {
+            logDrain = new LogDrain<LogRecord>("output_sems.txt", totalThreads, LOG_RING_RECORDS, writeLogRecord, getTimestamp);
+        }
+        catch (const exception &e)
+        {
+            cerr << "Error: " << e.what() << endl;
+            return 1;
+        }
+    }
+    if (!metricsSink.empty())
+    {
+        try
+        {
+            metrics = new LiveMetrics(metricsSink, totalThreads, np, metricsIntervalMs, getTimestamp);
+        }
+        catch (const exception &e)
+        {
+            cerr << "Error: " << e.what() << endl;
+            return 1;
+        }
+    }
 
     vector<pthread_t> producerThreads(np);
     vector<pthread_t> consumerThreads(nc);
@@ -217,7 +616,7 @@ int main(int argc, char *argv[])
     for (int i = 0; i < np; i++)
     {
         producer_global_ids[i] = i;
-        if (pthread_create(&producerThreads[i], NULL, producer, &producer_global_ids[i]) != 0)
+        if (pthread_create(&producerThreads[i], NULL, producerFn, &producer_global_ids[i]) != 0)
         {
             cerr << "Error: Unable to create producer thread " << i << endl;
             return 1;
@@ -227,7 +626,7 @@ int main(int argc, char *argv[])
     for (int i = 0; i < nc; i++)
     {
         consumer_global_ids[i] = i + np;
-        if (pthread_create(&consumerThreads[i], NULL, consumer, &consumer_global_ids[i]) != 0)
+        if (pthread_create(&consumerThreads[i], NULL, consumerFn, &consumer_global_ids[i]) != 0)
         {
             cerr << "Error: Unable to create consumer thread " << i << endl;
             return 1;
@@ -242,17 +641,58 @@ int main(int argc, char *argv[])
     {
         pthread_join(consumerThreads[i], NULL);
     }
+    long long elapsed_ns = getTimestamp();
+    if (metrics)
+        metrics->stop();
 
     long long totalDuration = duration_cast<milliseconds>(steady_clock::now() - base_time).count();
-    ostringstream oss;
-    oss << "Total execution time: " << totalDuration << " ms";
-    logBuffers[0] += oss.str() + "\n";
+    if constexpr (chromeTraceEnabled)
+        chromeTrace.write("trace_sems.json");
+    if (logDrain)
+        logDrain->close();
+    else
+    {
+        ostringstream oss;
+        oss << "Total execution time: " << totalDuration << " ms";
+        logBuffers[0] += oss.str() + "\n";
 
-    parseAndWriteLogs(logBuffers);
+        parseAndWriteLogs(logBuffers);
+    }
+
+    LatencyHistogram latency;
+    for (const LatencyHistogram &h : latencyHists)
+        latency.merge(h);
+    for (const string &line : latency.reportLines())
+        cout << line << endl;
+    cout << "Throughput: " << to_string(latency.count() * 1e9 / max(elapsed_ns, 1LL)) << " items/s" << endl;
+    if (elimination)
+    {
+        long long eliminated = 0;
+        for (long long n : eliminatedItems)
+            eliminated += n;
+        cout << "Eliminated handoffs: " << eliminated << " of " << latency.count() << " items ("
+             << to_string(100.0 * eliminated / max(latency.count(), 1LL)) << "%)" << endl;
+    }
 
-    sem_destroy(&sem_empty);
-    sem_destroy(&sem_full);
-    sem_destroy(&sem_mutex);
+    if (metrics)
+        cout << "Live metrics: " << metrics->samples() << " samples to " << metricsSink << endl;
+
+    if (logDrain)
+        cout << "Streamed log: " << logDrain->recordsWritten() << " lines, " << logDrain->ringRecords()
+             << " records of ring memory, " << logDrain->fullWaits() << " waits on a full ring" << endl;
+
+#ifdef FAST_SEM
+    FastSemaphoreStats stats;
+    buffer->synchronization().forEachSemaphore([&](const FastSemaphore &sem)
+                                               { stats.add(sem.stats()); });
+    cout << fastSemaphoreReport(stats) << endl;
+#endif
+
+    delete buffer;
+    delete spsc;
+    delete elimination;
+    delete logDrain;
+    delete metrics;
 
     return 0;
 }
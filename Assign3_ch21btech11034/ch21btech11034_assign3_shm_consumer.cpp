@@ -0,0 +1,227 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <pthread.h>
+#include <cstdlib>
+#include <algorithm>
+#include <memory>
+#include "latency_histogram.h"
+#include "pacing.h"
+#include "shm_buffer.h"
+
+using namespace std;
+using namespace std::chrono;
+
+// Consumer side of the cross-process version: nc consumer threads drain the
+// ShmBuffer that prod_cons-shm-producer (another process) fills. Consumer
+// thread ids start at np, as in the single-process programs.
+
+int capacity, np, nc, cntp, cntc;
+double mu_p, mu_c;
+// Same layout in both programs; enqueue_ns is steady_clock time since its epoch
+struct Item
+{
+    int id;
+    long long enqueue_ns;
+};
+ShmBuffer<Item> *buffer = nullptr;
+
+// Name of the shared memory object (--name=/NAME)
+string shmName = "/prod_cons_ch21btech11034";
+
+// Seed of the delay generators, random unless --seed=N; thread i uses seed + i
+unsigned seed = random_device{}();
+
+// Queueing latency (dequeue minus enqueue time, across the two processes)
+// recorded by each consumer
+vector<LatencyHistogram> latencyHists;
+
+vector<string> logBuffers;
+
+void writeOutputToFile(const string &output)
+{
+    ofstream outFile("output_shm_consumer.txt", ios::app);
+    if (outFile)
+        outFile << output << endl;
+    else
+        cout << "Error: Could not open output file." << endl;
+    outFile.close();
+}
+
+vector<string> splitByNewline(const string &buffer)
+{
+    vector<string> lines;
+    size_t start = 0, end;
+    while ((end = buffer.find('\n', start)) != string::npos)
+    {
+        string line = buffer.substr(start, end - start);
+        if (!line.empty())
+            lines.push_back(line);
+        start = end + 1;
+    }
+    if (start < buffer.size())
+        lines.push_back(buffer.substr(start));
+    return lines;
+}
+
+void parseAndWriteLogs(const vector<string> &buffers)
+{
+    vector<pair<long long, string>> logs;
+    for (const string &buffer : buffers)
+    {
+        vector<string> lines = splitByNewline(buffer);
+        for (const string &line : lines)
+        {
+            size_t lastSpace = line.find_last_of(' ');
+            if (lastSpace != string::npos)
+            {
+                string logMessage = line.substr(0, lastSpace);
+                string lastToken = line.substr(lastSpace + 1);
+                try
+                {
+                    long long timestamp = stoll(lastToken);
+                    logs.emplace_back(timestamp, logMessage);
+                }
+                catch (const std::invalid_argument &e)
+                {
+                    // Skip lines where the last token is not a number (e.g., total execution time line)
+                    continue;
+                }
+            }
+        }
+    }
+    sort(logs.begin(), logs.end(), [](const pair<long long, string> &a, const pair<long long, string> &b)
+         { return a.first < b.first; });
+    // Clear the output file first
+    ofstream clearFile("output_shm_consumer.txt", ios::out);
+    clearFile.close();
+    for (const auto &log : logs)
+    {
+        writeOutputToFile(log.second + " " + to_string(log.first));
+    }
+}
+
+long long steadyNs()
+{
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+long long getTimestamp()
+{
+    return steadyNs() - buffer->baseNs();
+}
+
+void *consumer(void *arg)
+{
+    int global_id = *(int *)arg;
+    // Exponentially distributed processing time per item (mean = mu_c ms)
+    Pacer pacer(ArrivalProcess(), mu_c, seed + global_id);
+
+    for (int i = 0; i < cntc; i++)
+    {
+        size_t pos;
+        const Item *slot = buffer->beginPop(pos);
+        long long cs_entry = getTimestamp();
+        // Read where the producer process wrote it
+        long long enqueued = slot->enqueue_ns;
+        long long dequeued = steadyNs();
+        long long cs_exit = getTimestamp();
+        buffer->commitPop();
+        {
+            ostringstream oss;
+            oss << "CONS_CS: " << global_id << " " << cs_entry << " " << cs_exit;
+            logBuffers[global_id - np] += oss.str() + "\n";
+        }
+        {
+            ostringstream oss;
+            oss << (i + 1) << "th item consumed by thread " << global_id
+                << " at " << cs_exit << " ms from buffer location " << pos;
+            logBuffers[global_id - np] += oss.str() + "\n";
+        }
+        latencyHists[global_id - np].record(dequeued - enqueued);
+
+        pacer.delay();
+    }
+    pthread_exit(NULL);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        cerr << "Usage: " << argv[0] << " inp-params.txt [--name=/NAME] [--seed=N]" << endl;
+        return 1;
+    }
+    for (int i = 2; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg.rfind("--name=", 0) == 0)
+            shmName = arg.substr(7);
+        else if (arg.rfind("--seed=", 0) == 0)
+            seed = static_cast<unsigned>(stoul(arg.substr(7)));
+        else
+        {
+            cerr << "Usage: " << argv[0] << " inp-params.txt [--name=/NAME] [--seed=N]" << endl;
+            return 1;
+        }
+    }
+
+    ifstream inputFile(argv[1]);
+    if (!inputFile)
+    {
+        cerr << "Error: Cannot open input file " << argv[1] << endl;
+        return 1;
+    }
+    inputFile >> capacity >> np >> nc >> cntp >> cntc >> mu_p >> mu_c;
+    inputFile.close();
+
+    unique_ptr<ShmBuffer<Item>> shm;
+    try
+    {
+        shm.reset(new ShmBuffer<Item>(shmName, capacity));
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    buffer = shm.get();
+    cout << (buffer->creator() ? "Created " : "Attached to ") << shmName << endl;
+
+    logBuffers.resize(nc, "");
+    latencyHists.assign(nc, LatencyHistogram());
+    auto start_time = steady_clock::now();
+
+    vector<pthread_t> consumerThreads(nc);
+    vector<int> consumer_global_ids(nc);
+    for (int i = 0; i < nc; i++)
+    {
+        consumer_global_ids[i] = i + np;
+        if (pthread_create(&consumerThreads[i], NULL, consumer, &consumer_global_ids[i]) != 0)
+        {
+            cerr << "Error: Unable to create consumer thread " << i << endl;
+            return 1;
+        }
+    }
+    for (int i = 0; i < nc; i++)
+    {
+        pthread_join(consumerThreads[i], NULL);
+    }
+    long long elapsed_ns = duration_cast<nanoseconds>(steady_clock::now() - start_time).count();
+
+    parseAndWriteLogs(logBuffers);
+
+    LatencyHistogram latency;
+    for (const LatencyHistogram &h : latencyHists)
+        latency.merge(h);
+    for (const string &line : latency.reportLines())
+        cout << line << endl;
+    cout << "Throughput: " << to_string(latency.count() * 1e9 / max(elapsed_ns, 1LL)) << " items/s" << endl;
+
+    return 0;
+}
@@ -0,0 +1,220 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <pthread.h>
+#include <cstdlib>
+#include <algorithm>
+#include <memory>
+#include "pacing.h"
+#include "shm_buffer.h"
+
+using namespace std;
+using namespace std::chrono;
+
+// Producer side of the cross-process version: np producer threads put items
+// into a ShmBuffer that prod_cons-shm-consumer (another process) drains.
+// Either program may be started first; the buffer is created by whichever
+// opens the name first. Timestamps count from the buffer's creation, so the
+// two output files share one time line.
+
+int capacity, np, nc, cntp, cntc;
+double mu_p, mu_c;
+// Same layout in both programs; enqueue_ns is steady_clock time since its epoch
+struct Item
+{
+    int id;
+    long long enqueue_ns;
+};
+ShmBuffer<Item> *buffer = nullptr;
+
+// Name of the shared memory object (--name=/NAME)
+string shmName = "/prod_cons_ch21btech11034";
+
+// How producers space their items (--arrival=exp|const|bursty[:ON_MS:OFF_MS])
+ArrivalProcess arrival;
+
+// Seed of the delay generators, random unless --seed=N; thread i uses seed + i
+unsigned seed = random_device{}();
+
+vector<string> logBuffers;
+
+void writeOutputToFile(const string &output)
+{
+    ofstream outFile("output_shm_producer.txt", ios::app);
+    if (outFile)
+        outFile << output << endl;
+    else
+        cout << "Error: Could not open output file." << endl;
+    outFile.close();
+}
+
+vector<string> splitByNewline(const string &buffer)
+{
+    vector<string> lines;
+    size_t start = 0, end;
+    while ((end = buffer.find('\n', start)) != string::npos)
+    {
+        string line = buffer.substr(start, end - start);
+        if (!line.empty())
+            lines.push_back(line);
+        start = end + 1;
+    }
+    if (start < buffer.size())
+        lines.push_back(buffer.substr(start));
+    return lines;
+}
+
+void parseAndWriteLogs(const vector<string> &buffers)
+{
+    vector<pair<long long, string>> logs;
+    for (const string &buffer : buffers)
+    {
+        vector<string> lines = splitByNewline(buffer);
+        for (const string &line : lines)
+        {
+            size_t lastSpace = line.find_last_of(' ');
+            if (lastSpace != string::npos)
+            {
+                string logMessage = line.substr(0, lastSpace);
+                string lastToken = line.substr(lastSpace + 1);
+                try
+                {
+                    long long timestamp = stoll(lastToken);
+                    logs.emplace_back(timestamp, logMessage);
+                }
+                catch (const std::invalid_argument &e)
+                {
+                    // Skip lines where the last token is not a number (e.g., total execution time line)
+                    continue;
+                }
+            }
+        }
+    }
+    sort(logs.begin(), logs.end(), [](const pair<long long, string> &a, const pair<long long, string> &b)
+         { return a.first < b.first; });
+    // Clear the output file first
+    ofstream clearFile("output_shm_producer.txt", ios::out);
+    clearFile.close();
+    for (const auto &log : logs)
+    {
+        writeOutputToFile(log.second + " " + to_string(log.first));
+    }
+}
+
+long long steadyNs()
+{
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+long long getTimestamp()
+{
+    return steadyNs() - buffer->baseNs();
+}
+
+void *producer(void *arg)
+{
+    int global_id = *(int *)arg;
+    // Open-loop arrivals (--arrival=, exponential by default)
+    Pacer pacer(arrival, mu_p, seed + global_id);
+
+    for (int i = 0; i < cntp; i++)
+    {
+        size_t pos;
+        // Blocks for a free slot and the mutex, both shared with the other process
+        Item *slot = buffer->beginPush(pos);
+        long long cs_entry = getTimestamp();
+        // Built in place: the consumer process reads this same memory
+        slot->id = global_id * 1000 + i;
+        slot->enqueue_ns = steadyNs();
+        long long cs_exit = getTimestamp();
+        buffer->commitPush();
+        {
+            ostringstream oss;
+            oss << "PROD_CS: " << global_id << " " << cs_entry << " " << cs_exit;
+            logBuffers[global_id] += oss.str() + "\n";
+        }
+        {
+            ostringstream oss;
+            oss << (i + 1) << "th item produced by thread " << global_id
+                << " at " << cs_exit << " ms into buffer location " << pos;
+            logBuffers[global_id] += oss.str() + "\n";
+        }
+
+        pacer.nextArrival();
+    }
+    pthread_exit(NULL);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        cerr << "Usage: " << argv[0] << " inp-params.txt [--name=/NAME] [--arrival=MODE] [--seed=N]" << endl;
+        return 1;
+    }
+    for (int i = 2; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg.rfind("--name=", 0) == 0)
+            shmName = arg.substr(7);
+        else if (arg.rfind("--seed=", 0) == 0)
+            seed = static_cast<unsigned>(stoul(arg.substr(7)));
+        else if (arg.rfind("--arrival=", 0) != 0 || !parseArrivalProcess(arg.substr(10), arrival))
+        {
+            cerr << "Usage: " << argv[0] << " inp-params.txt [--name=/NAME] [--arrival=MODE] [--seed=N]" << endl;
+            return 1;
+        }
+    }
+
+    ifstream inputFile(argv[1]);
+    if (!inputFile)
+    {
+        cerr << "Error: Cannot open input file " << argv[1] << endl;
+        return 1;
+    }
+    inputFile >> capacity >> np >> nc >> cntp >> cntc >> mu_p >> mu_c;
+    inputFile.close();
+
+    unique_ptr<ShmBuffer<Item>> shm;
+    try
+    {
+        shm.reset(new ShmBuffer<Item>(shmName, capacity));
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    buffer = shm.get();
+    cout << (buffer->creator() ? "Created " : "Attached to ") << shmName << endl;
+
+    logBuffers.resize(np, "");
+    auto start_time = steady_clock::now();
+
+    vector<pthread_t> producerThreads(np);
+    vector<int> producer_global_ids(np);
+    for (int i = 0; i < np; i++)
+    {
+        producer_global_ids[i] = i;
+        if (pthread_create(&producerThreads[i], NULL, producer, &producer_global_ids[i]) != 0)
+        {
+            cerr << "Error: Unable to create producer thread " << i << endl;
+            return 1;
+        }
+    }
+    for (int i = 0; i < np; i++)
+    {
+        pthread_join(producerThreads[i], NULL);
+    }
+
+    long long totalDuration = duration_cast<milliseconds>(steady_clock::now() - start_time).count();
+    parseAndWriteLogs(logBuffers);
+    cout << "Produced " << np * cntp << " items in " << totalDuration << " ms" << endl;
+
+    return 0;
+}
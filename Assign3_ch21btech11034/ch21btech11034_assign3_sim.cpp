@@ -0,0 +1,298 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <deque>
+#include <queue>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include "latency_histogram.h"
+#include "pacing.h"
+
+using namespace std;
+using namespace std::chrono;
+
+// Discrete-event simulation of prod_cons-sems on a virtual clock. Producers
+// and consumers follow the same steps as the threads of the semaphore version
+// (sem_wait(empty/full), sem_wait(mutex), critical section, sem_post, delay),
+// but every wait is a queue of simulated threads and every sleep is an event
+// in the future, so a run takes as long as its events do to process, not as
+// long as the delays add up to. Semaphores and the mutex hand over in FIFO
+// order, a critical section takes cs_ns of virtual time and a blocked thread
+// needs wake_ns to run again after the post that wakes it. All delays come
+// from Pacers seeded with seed + thread id, so a given input and seed always
+// produce the same output.
+
+int capacity, np, nc, cntp, cntc;
+double mu_p, mu_c;
+
+// How producers space their items (--arrival=exp|const|bursty[:ON_MS:OFF_MS])
+ArrivalProcess arrival;
+
+// Seed of the delay generators (--seed=N)
+unsigned seed = 1;
+
+// Virtual duration of one critical section (--cs-ns=N)
+long long cs_ns = 1000;
+
+// Virtual time from a sem_post to the woken thread running (--wake-ns=N)
+long long wake_ns = 25000;
+
+enum Step
+{
+    WANT_SLOT, // producer: sem_wait(&sem_empty)
+    WANT_ITEM, // consumer: sem_wait(&sem_full)
+    WANT_MUTEX,
+    CS_DONE
+};
+
+struct SimThread
+{
+    int global_id;
+    bool producer;
+    int done = 0;
+    long long cs_entry = 0;
+    Pacer pacer;
+    // Open-loop arrival time of the producer's next item
+    long long next_arrival = 0;
+};
+
+struct Event
+{
+    long long time;
+    long long seq; // ties are handled in the order they were scheduled
+    int thread;
+    Step step;
+
+    bool operator>(const Event &other) const
+    {
+        return time != other.time ? time > other.time : seq > other.seq;
+    }
+};
+
+vector<SimThread> threads;
+priority_queue<Event, vector<Event>, greater<Event>> events;
+long long event_seq = 0;
+long long now_ns = 0;
+
+// Semaphore values and the FIFO queues of threads blocked on them
+int empty_slots, full_slots;
+bool mutex_held = false;
+deque<int> empty_waiters, full_waiters, mutex_waiters;
+
+// Buffer slots hold the enqueue time of their item
+vector<long long> buffer;
+int in_index = 0, out_index = 0;
+
+LatencyHistogram latency;
+// Events run in time order, so the log is already sorted
+string log_text;
+
+void schedule(long long time, int thread, Step step)
+{
+    events.push({time, event_seq++, thread, step});
+}
+
+// The thread holds the mutex from now on
+void enterCS(int t)
+{
+    mutex_held = true;
+    schedule(now_ns + cs_ns, t, CS_DONE);
+}
+
+void criticalSection(int t)
+{
+    SimThread &th = threads[t];
+    int pos;
+    if (th.producer)
+    {
+        pos = in_index;
+        buffer[in_index] = now_ns;
+        in_index = (in_index + 1) % capacity;
+    }
+    else
+    {
+        pos = out_index;
+        latency.record(now_ns - buffer[out_index]);
+        out_index = (out_index + 1) % capacity;
+    }
+    th.done++;
+
+    ostringstream cs, item;
+    if (th.producer)
+    {
+        cs << "PROD_CS: " << th.global_id << " " << th.cs_entry;
+        item << th.done << "th item produced by thread " << th.global_id
+             << " at " << now_ns << " ms into buffer location " << pos;
+    }
+    else
+    {
+        cs << "CONS_CS: " << th.global_id << " " << th.cs_entry;
+        item << th.done << "th item consumed by thread " << th.global_id
+             << " at " << now_ns << " ms from buffer location " << pos;
+    }
+    log_text += cs.str() + " " + to_string(now_ns) + "\n";
+    log_text += item.str() + "\n";
+}
+
+// sem_post(&sem_mutex)
+void releaseMutex()
+{
+    mutex_held = false;
+    if (!mutex_waiters.empty())
+    {
+        int next = mutex_waiters.front();
+        mutex_waiters.pop_front();
+        enterCS(next);
+    }
+}
+
+// sem_post(&sem_full) or sem_post(&sem_empty): wakes the longest waiter, if any
+void post(int &value, deque<int> &waiters)
+{
+    if (waiters.empty())
+    {
+        value++;
+        return;
+    }
+    int next = waiters.front();
+    waiters.pop_front();
+    schedule(now_ns + wake_ns, next, WANT_MUTEX);
+}
+
+void step(const Event &ev)
+{
+    int t = ev.thread;
+    SimThread &th = threads[t];
+    switch (ev.step)
+    {
+    case WANT_SLOT:
+    case WANT_ITEM:
+    {
+        int &value = th.producer ? empty_slots : full_slots;
+        if (value > 0)
+        {
+            value--;
+            schedule(now_ns, t, WANT_MUTEX);
+        }
+        else
+            (th.producer ? empty_waiters : full_waiters).push_back(t);
+        break;
+    }
+    case WANT_MUTEX:
+        th.cs_entry = now_ns;
+        if (mutex_held)
+            mutex_waiters.push_back(t);
+        else
+            enterCS(t);
+        break;
+    case CS_DONE:
+        criticalSection(t);
+        releaseMutex();
+        if (th.producer)
+        {
+            post(full_slots, full_waiters);
+            if (th.done < cntp)
+            {
+                th.next_arrival += th.pacer.gapNs();
+                schedule(max(now_ns, th.next_arrival), t, WANT_SLOT);
+            }
+        }
+        else
+        {
+            post(empty_slots, empty_waiters);
+            if (th.done < cntc)
+                schedule(now_ns + th.pacer.gapNs(), t, WANT_ITEM);
+        }
+        break;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        cerr << "Usage: " << argv[0] << " inp-params.txt [--seed=N] [--cs-ns=N] [--wake-ns=N] [--arrival=MODE]" << endl;
+        return 1;
+    }
+    for (int i = 2; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg.rfind("--seed=", 0) == 0)
+            seed = static_cast<unsigned>(stoul(arg.substr(7)));
+        else if (arg.rfind("--cs-ns=", 0) == 0)
+            cs_ns = max(0LL, stoll(arg.substr(8)));
+        else if (arg.rfind("--wake-ns=", 0) == 0)
+            wake_ns = max(0LL, stoll(arg.substr(10)));
+        else if (arg.rfind("--arrival=", 0) != 0 || !parseArrivalProcess(arg.substr(10), arrival))
+        {
+            cerr << "Usage: " << argv[0] << " inp-params.txt [--seed=N] [--cs-ns=N] [--wake-ns=N] [--arrival=MODE]" << endl;
+            return 1;
+        }
+    }
+
+    ifstream inputFile(argv[1]);
+    if (!inputFile)
+    {
+        cerr << "Error: Cannot open input file " << argv[1] << endl;
+        return 1;
+    }
+    inputFile >> capacity >> np >> nc >> cntp >> cntc >> mu_p >> mu_c;
+    inputFile.close();
+
+    if (capacity < 1)
+    {
+        cerr << "Error: capacity must be positive" << endl;
+        return 1;
+    }
+    buffer.assign(capacity, 0);
+    empty_slots = capacity;
+    full_slots = 0;
+
+    auto wallStart = steady_clock::now();
+
+    // Thread ids and start order match the real programs: producers first
+    for (int i = 0; i < np + nc; i++)
+    {
+        bool producer = i < np;
+        Pacer pacer(producer ? arrival : ArrivalProcess(), producer ? mu_p : mu_c, seed + i);
+        threads.push_back(SimThread{i, producer, 0, 0, pacer, 0});
+    }
+    for (int i = 0; i < np + nc; i++)
+    {
+        if (threads[i].producer ? cntp > 0 : cntc > 0)
+            schedule(0, i, threads[i].producer ? WANT_SLOT : WANT_ITEM);
+    }
+
+    long long processed = 0;
+    while (!events.empty())
+    {
+        Event ev = events.top();
+        events.pop();
+        now_ns = ev.time;
+        step(ev);
+        processed++;
+    }
+
+    // The real programs would hang here; the simulation just stops
+    size_t stuck = empty_waiters.size() + full_waiters.size();
+    if (stuck > 0)
+        cerr << "Warning: " << stuck << " threads still blocked when the events ran out "
+             << "(np * cntp != nc * cntc?)" << endl;
+
+    ofstream outFile("output_sim.txt", ios::out);
+    if (outFile)
+        outFile << log_text;
+    else
+        cout << "Error: Could not open output file." << endl;
+    outFile.close();
+
+    for (const string &line : latency.reportLines())
+        cout << line << endl;
+    cout << "Throughput: " << to_string(latency.count() * 1e9 / max(now_ns, 1LL)) << " items/s" << endl;
+    cout << "Simulated events: " << processed << ", virtual time: " << now_ns << " ns, wall time: "
+         << duration_cast<microseconds>(steady_clock::now() - wallStart).count() << " us" << endl;
+
+    return 0;
+}
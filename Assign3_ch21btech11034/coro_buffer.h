@@ -0,0 +1,212 @@
+#ifndef CORO_BUFFER_H
+#define CORO_BUFFER_H
+
+// Bounded buffer for coroutines on a CoroScheduler (coro_scheduler.h):
+//
+//   size_t pos = co_await buffer.push(item);          // slot it went into
+//   CoroBuffer<T>::Popped p = co_await buffer.pop();  // item, slot, enqueue time
+//
+// Where the pthread versions block in sem_wait or on a condition variable,
+// these suspend the calling task and free its worker for other tasks. Tasks
+// waiting on a full (or empty) buffer queue up in FIFO order. Whoever frees
+// what they wait for finishes their operation for them under the buffer
+// lock: a pop from a full buffer moves the first waiting producer's item
+// into the freed slot, a push to an empty buffer hands the item to the
+// first waiting consumer. The woken task is then only rescheduled, so it
+// never finds the buffer taken again by someone else.
+//
+// The ring itself is the same as in the other versions (in/out indices
+// under one lock); each slot also keeps the time its item went in.
+
+#include <cstddef>
+#include <coroutine>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include "coro_scheduler.h"
+
+template <typename T>
+class CoroBuffer
+{
+public:
+    typedef long long (*ClockFn)();
+
+    struct Popped
+    {
+        T item;
+        size_t pos;
+        long long enqueuedNs; // from the clock given to the constructor
+    };
+
+    CoroBuffer(size_t capacity, CoroScheduler &scheduler, ClockFn now)
+        : cap(capacity), slots(capacity), scheduler(scheduler), now(now)
+    {
+    }
+
+    CoroBuffer(const CoroBuffer &) = delete;
+    CoroBuffer &operator=(const CoroBuffer &) = delete;
+
+    class PushAwaiter
+    {
+    public:
+        bool await_ready() const
+        {
+            return false;
+        }
+        // Returns false (carry on) when there was room
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            handle = h;
+            return buffer.pushOrWait(this);
+        }
+        size_t await_resume() const
+        {
+            return pos;
+        }
+
+    private:
+        friend class CoroBuffer;
+        PushAwaiter(CoroBuffer &buffer, const T &item) : buffer(buffer), item(item) {}
+        CoroBuffer &buffer;
+        T item;
+        size_t pos = 0;
+        std::coroutine_handle<> handle;
+    };
+
+    class PopAwaiter
+    {
+    public:
+        bool await_ready() const
+        {
+            return false;
+        }
+        // Returns false (carry on) when there was an item
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            handle = h;
+            return buffer.popOrWait(this);
+        }
+        Popped await_resume() const
+        {
+            return result;
+        }
+
+    private:
+        friend class CoroBuffer;
+        explicit PopAwaiter(CoroBuffer &buffer) : buffer(buffer) {}
+        CoroBuffer &buffer;
+        Popped result{};
+        std::coroutine_handle<> handle;
+    };
+
+    PushAwaiter push(const T &item)
+    {
+        return PushAwaiter(*this, item);
+    }
+
+    PopAwaiter pop()
+    {
+        return PopAwaiter(*this);
+    }
+
+    // Pushes that found the buffer full and suspended
+    long long producerWaits() const
+    {
+        return producerSuspends;
+    }
+
+    // Pops that found the buffer empty and suspended
+    long long consumerWaits() const
+    {
+        return consumerSuspends;
+    }
+
+private:
+    struct Slot
+    {
+        T item;
+        long long enqueuedNs;
+    };
+
+    // The awaiter's task may be resumed by another worker as soon as the
+    // lock is released, so neither function touches it after that
+    bool pushOrWait(PushAwaiter *p)
+    {
+        std::coroutine_handle<> wakeConsumer;
+        {
+            std::lock_guard<std::mutex> lock(m);
+            if (count == cap)
+            {
+                waitingProducers.push_back(p);
+                producerSuspends++;
+                return true;
+            }
+            p->pos = put(p->item);
+            if (!waitingConsumers.empty())
+            {
+                PopAwaiter *c = waitingConsumers.front();
+                waitingConsumers.pop_front();
+                c->result = take();
+                wakeConsumer = c->handle;
+            }
+        }
+        if (wakeConsumer)
+            scheduler.schedule(wakeConsumer);
+        return false;
+    }
+
+    bool popOrWait(PopAwaiter *c)
+    {
+        std::coroutine_handle<> wakeProducer;
+        {
+            std::lock_guard<std::mutex> lock(m);
+            if (count == 0)
+            {
+                waitingConsumers.push_back(c);
+                consumerSuspends++;
+                return true;
+            }
+            c->result = take();
+            if (!waitingProducers.empty())
+            {
+                PushAwaiter *p = waitingProducers.front();
+                waitingProducers.pop_front();
+                p->pos = put(p->item);
+                wakeProducer = p->handle;
+            }
+        }
+        if (wakeProducer)
+            scheduler.schedule(wakeProducer);
+        return false;
+    }
+
+    size_t put(const T &item)
+    {
+        size_t pos = in;
+        slots[pos] = Slot{item, now()};
+        in = (in + 1) % cap;
+        count++;
+        return pos;
+    }
+
+    Popped take()
+    {
+        size_t pos = out;
+        out = (out + 1) % cap;
+        count--;
+        return Popped{slots[pos].item, pos, slots[pos].enqueuedNs};
+    }
+
+    const size_t cap;
+    std::vector<Slot> slots;
+    CoroScheduler &scheduler;
+    const ClockFn now;
+    std::mutex m;
+    size_t in = 0, out = 0, count = 0;
+    std::deque<PushAwaiter *> waitingProducers;
+    std::deque<PopAwaiter *> waitingConsumers;
+    long long producerSuspends = 0;
+    long long consumerSuspends = 0;
+};
+
+#endif
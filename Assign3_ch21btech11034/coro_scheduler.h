@@ -0,0 +1,260 @@
+#ifndef CORO_SCHEDULER_H
+#define CORO_SCHEDULER_H
+
+// M:N scheduler for C++20 coroutines: any number of CoroTasks run on a small
+// pool of worker threads. A task runs on a worker until it suspends, either
+// on a CoroBuffer (coro_buffer.h) or in sleepUntil(); whatever wakes it puts
+// it back on the ready queue, and the next free worker resumes it. A
+// suspended task costs its coroutine frame (a few hundred bytes plus its
+// locals) instead of a thread stack, and switching tasks is a function call
+// and return on the same worker instead of a trip through the kernel.
+//
+// The ready queue and the timers are guarded by one mutex. A worker with
+// nothing ready sleeps on a condition variable until the earliest timer is
+// due or a task is made ready, so sleepUntil() has the precision of a
+// condition variable timeout (tens of microseconds), not that of pacing.h's
+// spin. run() returns once every spawned task has finished.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class CoroScheduler;
+
+// Coroutine type for the tasks; created suspended and started by spawn()
+class CoroTask
+{
+public:
+    struct promise_type
+    {
+        CoroScheduler *scheduler = nullptr;
+
+        CoroTask get_return_object()
+        {
+            return CoroTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+        // Frees the frame and tells the scheduler the task is done
+        struct FinalAwaiter
+        {
+            bool await_ready() noexcept
+            {
+                return false;
+            }
+            void await_suspend(std::coroutine_handle<promise_type> h) noexcept;
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept
+        {
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+
+    CoroTask(CoroTask &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    CoroTask(const CoroTask &) = delete;
+    CoroTask &operator=(const CoroTask &) = delete;
+
+    // A task never spawned is destroyed with its handle
+    ~CoroTask()
+    {
+        if (handle)
+            handle.destroy();
+    }
+
+private:
+    friend class CoroScheduler;
+    explicit CoroTask(std::coroutine_handle<promise_type> h) : handle(h) {}
+    std::coroutine_handle<promise_type> handle;
+};
+
+class CoroScheduler
+{
+public:
+    typedef std::chrono::steady_clock::time_point TimePoint;
+
+    explicit CoroScheduler(size_t workers) : workers(std::max<size_t>(1, workers)) {}
+
+    CoroScheduler(const CoroScheduler &) = delete;
+    CoroScheduler &operator=(const CoroScheduler &) = delete;
+
+    size_t workerCount() const
+    {
+        return workers;
+    }
+
+    // Queues the task to start; the scheduler owns it from here on
+    void spawn(CoroTask task)
+    {
+        std::coroutine_handle<CoroTask::promise_type> h = std::exchange(task.handle, nullptr);
+        h.promise().scheduler = this;
+        {
+            std::lock_guard<std::mutex> lock(m);
+            live++;
+        }
+        schedule(h);
+    }
+
+    // Makes a suspended task ready; may be called from any thread
+    void schedule(std::coroutine_handle<> h)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            ready.push_back(h);
+        }
+        wake.notify_one();
+    }
+
+    // co_await sleepUntil(t) suspends the task until t
+    struct SleepAwaiter
+    {
+        CoroScheduler &scheduler;
+        TimePoint deadline;
+
+        bool await_ready() const
+        {
+            return std::chrono::steady_clock::now() >= deadline;
+        }
+        void await_suspend(std::coroutine_handle<> h)
+        {
+            scheduler.addTimer(deadline, h);
+        }
+        void await_resume() const {}
+    };
+
+    SleepAwaiter sleepUntil(TimePoint deadline)
+    {
+        return SleepAwaiter{*this, deadline};
+    }
+
+    // Runs the workers until all spawned tasks have finished
+    void run()
+    {
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < workers; i++)
+            threads.emplace_back(&CoroScheduler::work, this);
+        work();
+        for (std::thread &t : threads)
+            t.join();
+    }
+
+    // Times a task was resumed by a worker, the first start included
+    long long resumes() const
+    {
+        return resumed;
+    }
+
+    // Times a task waited for a timer
+    long long timerWaits() const
+    {
+        return timed;
+    }
+
+private:
+    friend struct CoroTask::promise_type::FinalAwaiter;
+
+    struct Timer
+    {
+        TimePoint deadline;
+        std::coroutine_handle<> handle;
+        bool operator>(const Timer &other) const
+        {
+            return deadline > other.deadline;
+        }
+    };
+
+    void addTimer(TimePoint deadline, std::coroutine_handle<> h)
+    {
+        bool earliest;
+        {
+            std::lock_guard<std::mutex> lock(m);
+            earliest = timers.empty() || deadline < timers.top().deadline;
+            timers.push(Timer{deadline, h});
+            timed++;
+        }
+        // A sleeping worker may be waiting for a later deadline
+        if (earliest)
+            wake.notify_one();
+    }
+
+    void finished()
+    {
+        bool last;
+        {
+            std::lock_guard<std::mutex> lock(m);
+            last = --live == 0;
+        }
+        if (last)
+            wake.notify_all();
+    }
+
+    void work()
+    {
+        std::unique_lock<std::mutex> lock(m);
+        for (;;)
+        {
+            TimePoint now = std::chrono::steady_clock::now();
+            while (!timers.empty() && timers.top().deadline <= now)
+            {
+                ready.push_back(timers.top().handle);
+                timers.pop();
+            }
+            if (!ready.empty())
+            {
+                std::coroutine_handle<> h = ready.front();
+                ready.pop_front();
+                resumed++;
+                // More left: let another worker take them
+                if (!ready.empty())
+                    wake.notify_one();
+                lock.unlock();
+                // h may be resumed elsewhere before this returns, so it is
+                // not touched afterwards
+                h.resume();
+                lock.lock();
+                continue;
+            }
+            if (live == 0)
+                return;
+            if (timers.empty())
+                wake.wait(lock);
+            else
+                wake.wait_until(lock, timers.top().deadline);
+        }
+    }
+
+    const size_t workers;
+    std::mutex m;
+    std::condition_variable wake;
+    std::deque<std::coroutine_handle<>> ready;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    long long live = 0;
+    long long resumed = 0;
+    long long timed = 0;
+};
+
+inline void CoroTask::promise_type::FinalAwaiter::await_suspend(std::coroutine_handle<promise_type> h) noexcept
+{
+    CoroScheduler *scheduler = h.promise().scheduler;
+    h.destroy();
+    scheduler->finished();
+}
+
+#endif
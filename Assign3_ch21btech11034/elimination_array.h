@@ -0,0 +1,151 @@
+#ifndef ELIMINATION_ARRAY_H
+#define ELIMINATION_ARRAY_H
+
+// Slots through which a producer hands an item straight to a consumer that
+// is waiting for one, so the item skips the buffer: no slot is written and
+// read back, and no sem_empty/sem_full round trip is needed for it.
+//
+// Each consumer owns one slot. When it finds the buffer empty it parks in
+// its slot (WAITING) and sleeps on the slot's semaphore. An arriving
+// producer first looks for a WAITING slot, claims it with a CAS, stores the
+// item and wakes that consumer. A consumer that finds an item in the buffer
+// after all withdraws from its slot with a CAS of its own, so each parked
+// consumer is taken by at most one producer.
+//
+// An item can still reach the buffer just as a consumer parks. To avoid a
+// lost wakeup, the consumer checks the buffer again after parking, and the
+// producer calls nudge() after adding to the buffer, which wakes one parked
+// consumer without an item so it looks at the buffer again. Both sides put
+// a seq_cst fence between their write and their read, so at least one of
+// them sees the other. A consumer that took a buffer token but then lost
+// its slot to a producer puts the token back, and must nudge() as well: the
+// consumer nudged for that token may have found it gone and parked again.
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <vector>
+#include <semaphore.h>
+
+template <typename T>
+class EliminationArray
+{
+public:
+    explicit EliminationArray(size_t consumers) : slots(consumers)
+    {
+        for (Slot &s : slots)
+        {
+            s.state.store(FREE, std::memory_order_relaxed);
+            sem_init(&s.wake, 0, 0);
+        }
+    }
+
+    ~EliminationArray()
+    {
+        for (Slot &s : slots)
+            sem_destroy(&s.wake);
+    }
+
+    EliminationArray(const EliminationArray &) = delete;
+    EliminationArray &operator=(const EliminationArray &) = delete;
+
+    size_t size() const
+    {
+        return slots.size();
+    }
+
+    // Producer: gives item to a parked consumer, looking from slot start
+    // on. Returns false (item not taken) when no consumer is parked.
+    bool tryHandOff(const T &item, size_t start, size_t &slot)
+    {
+        size_t n = slots.size();
+        for (size_t i = 0; i < n; i++)
+        {
+            Slot &s = slots[(start + i) % n];
+            int expected = WAITING;
+            if (s.state.load(std::memory_order_relaxed) == WAITING &&
+                s.state.compare_exchange_strong(expected, CLAIMED, std::memory_order_acquire))
+            {
+                s.value = item;
+                s.state.store(HANDED, std::memory_order_release);
+                sem_post(&s.wake);
+                slot = (start + i) % n;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Producer, after adding an item to the buffer: wakes one parked
+    // consumer, if any, to take it from there
+    void nudge(size_t start)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        size_t n = slots.size();
+        for (size_t i = 0; i < n; i++)
+        {
+            Slot &s = slots[(start + i) % n];
+            int expected = WAITING;
+            if (s.state.load(std::memory_order_relaxed) == WAITING &&
+                s.state.compare_exchange_strong(expected, NUDGED, std::memory_order_relaxed))
+            {
+                sem_post(&s.wake);
+                return;
+            }
+        }
+    }
+
+    // Consumer owning slot: announces that it waits. Must be followed by a
+    // last look at the buffer, then withdraw() or wait().
+    void park(size_t slot)
+    {
+        // Release: the producer that claims the slot must not overwrite the
+        // value before this consumer has read the previous one
+        slots[slot].state.store(WAITING, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    // Consumer: leaves the slot after finding an item in the buffer. False
+    // when a producer got there first; its item or nudge then has to be
+    // collected with wait().
+    bool withdraw(size_t slot)
+    {
+        int expected = WAITING;
+        return slots[slot].state.compare_exchange_strong(expected, FREE, std::memory_order_relaxed);
+    }
+
+    // Consumer: sleeps until a producer takes the slot. Returns true with
+    // the handed item, or false after a nudge.
+    bool wait(size_t slot, T &item)
+    {
+        Slot &s = slots[slot];
+        while (sem_wait(&s.wake) != 0 && errno == EINTR)
+            ;
+        bool handed = s.state.load(std::memory_order_acquire) == HANDED;
+        if (handed)
+            item = s.value;
+        s.state.store(FREE, std::memory_order_relaxed);
+        return handed;
+    }
+
+private:
+    enum
+    {
+        FREE,
+        WAITING,
+        CLAIMED, // a producer is storing its item
+        HANDED,
+        NUDGED
+    };
+
+    struct alignas(64) Slot
+    {
+        std::atomic<int> state;
+        sem_t wake;
+        T value;
+    };
+
+    std::vector<Slot> slots;
+};
+
+#endif
@@ -2,6 +2,7 @@
 import subprocess
 import os
 import re
+import sys
 import time
 import matplotlib.pyplot as plt
 import numpy as np
@@ -9,13 +10,31 @@ import numpy as np
 
 SEM_EXEC = "./prod_cons-sems"     
 LOCK_EXEC = "./prod_cons-locks"   
+RING_EXEC = "./prod_cons-ring"
+LOCK_POLL_EXEC = "./prod_cons-locks-poll"  # built with -DPOLL_WAIT (make poll)
+SIM_EXEC = "./prod_cons-sim"  # virtual-time simulation of prod_cons-sems
+CORO_EXEC = "./prod_cons-coro"  # C++20 coroutines on a worker pool
 
 SEM_OUTPUT = "output_sems.txt"   
 LOCK_OUTPUT = "output_locks.txt"  
+RING_OUTPUT = "output_ring.txt"
+SIM_OUTPUT = "output_sim.txt"
+CORO_OUTPUT = "output_coro.txt"
+
+LATENCY_RESULTS = "latency_results.csv"
+SIM_RESULTS = "sim_sweep.csv"
+ELASTIC_RESULTS = "elastic_results.csv"
+ELIMINATION_RESULTS = "elimination_results.csv"
+LANE_RESULTS = "lane_results.csv"
+OVERFLOW_RESULTS = "overflow_results.csv"
+CORO_RESULTS = "coro_results.csv"
 
 CAPACITY = 100
 NUM_TRIALS = 3 
 
+# One row per (configuration, program): queueing latency and throughput
+latency_rows = []
+
 
 def write_input_file(capacity, np_val, nc_val, cntp, cntc, mu_p, mu_c):
     """Writes the parameters to inp-params.txt"""
@@ -23,31 +42,81 @@ def write_input_file(capacity, np_val, nc_val, cntp, cntc, mu_p, mu_c):
       
         f.write(f"{int(capacity)} {int(np_val)} {int(nc_val)} {int(cntp)} {int(cntc)} {mu_p} {mu_c}\n") # Ensure ints where needed
 
-def run_experiment(executable, output_file):
-    """Runs the specified C++ executable and waits for completion."""
+def run_experiment(executable, output_file, extra_args=(), settle=0.1):
+    """Runs the specified C++ executable and waits for completion, then
+       waits settle seconds more. Returns (output file, captured stdout), or
+       (None, "") if the run failed."""
     if os.path.exists(output_file):
         os.remove(output_file)
     try:
         result = subprocess.run(
-            [executable, "inp-params.txt"], 
+            [executable, "inp-params.txt", *extra_args], 
             capture_output=True, text=True, check=True, timeout=120 
         ) 
     except subprocess.CalledProcessError as e:
         print(f"Error running {executable}: {e}")
         print(f"Stderr: {e.stderr}")
-        return None 
+        return None, ""
     except subprocess.TimeoutExpired:
         print(f"Timeout running {executable}")
-        return None 
+        return None, ""
     except FileNotFoundError:
         print(f"Error: Executable {executable} not found. Make sure it is compiled and in the current directory.")
         exit(1) 
 
-    time.sleep(0.1) 
+    time.sleep(settle)
     if not os.path.exists(output_file):
         print(f"Error: Output file {output_file} was not created by {executable}.")
-        return None 
-    return output_file
+        return None, ""
+    return output_file, result.stdout
+
+def parse_latency_report(stdout):
+    """
+    Parses the summary the programs print at exit:
+      Queueing latency p50: <ns> ns
+      Queueing latency p99: <ns> ns
+      Queueing latency max: <ns> ns
+      Throughput: <items/s> items/s
+    Returns latencies in milliseconds; missing values are left out.
+    """
+    values = {}
+    for key in ("p50", "p99", "max"):
+        match = re.search(rf"Queueing latency {key}: (\d+) ns", stdout)
+        if match:
+            values[key] = int(match.group(1)) / 1_000_000.0
+    match = re.search(r"Throughput: ([\d.]+) items/s", stdout)
+    if match:
+        values["throughput"] = float(match.group(1))
+    return values
+
+def record_latency(config, program, reports):
+    """Adds one latency_rows entry from the per-trial reports: mean p50/p99/throughput, worst max."""
+    reports = [r for r in reports if len(r) == 4]
+    if not reports:
+        return
+    row = {
+        "config": config,
+        "program": os.path.basename(program),
+        "p50_ms": np.mean([r["p50"] for r in reports]),
+        "p99_ms": np.mean([r["p99"] for r in reports]),
+        "max_ms": max(r["max"] for r in reports),
+        "throughput": np.mean([r["throughput"] for r in reports]),
+    }
+    latency_rows.append(row)
+    print(f"  Queueing latency: p50={row['p50_ms']:.4f} ms, p99={row['p99_ms']:.4f} ms, max={row['max_ms']:.4f} ms, throughput={row['throughput']:.0f} items/s")
+
+def save_latency_results(filename=LATENCY_RESULTS):
+    """Writes latency_rows as CSV and prints them as a table."""
+    if not latency_rows:
+        return
+    with open(filename, "w") as f:
+        f.write("config,program,p50_ms,p99_ms,max_ms,throughput_items_per_s\n")
+        for row in latency_rows:
+            f.write(f"{row['config']},{row['program']},{row['p50_ms']:.6f},{row['p99_ms']:.6f},{row['max_ms']:.6f},{row['throughput']:.1f}\n")
+    print(f"\n{'Configuration':<28} {'Program':<44} {'p50 (ms)':>10} {'p99 (ms)':>10} {'max (ms)':>10} {'items/s':>10}")
+    for row in latency_rows:
+        print(f"{row['config']:<28} {row['program']:<44} {row['p50_ms']:>10.4f} {row['p99_ms']:>10.4f} {row['max_ms']:>10.4f} {row['throughput']:>10.0f}")
+    print(f"Latency results saved to {filename}")
 
 def parse_cs_times(output_file):
     """
@@ -85,18 +154,21 @@ def parse_cs_times(output_file):
     avg_cons_ms = np.mean(cons_times_ms) if cons_times_ms else 0
     return avg_prod_ms, avg_cons_ms
 
-def run_trials(executable, output_file, trials=NUM_TRIALS):
-    """Runs the experiment multiple times and averages the CS times."""
+def run_trials(executable, output_file, trials=NUM_TRIALS, config=None):
+    """Runs the experiment multiple times and averages the CS times.
+       With a config label the queueing latency summary is recorded as well."""
     prod_list = []
     cons_list = []
+    reports = []
     print(f"  Running {executable} ({trials} trials)...")
     for i in range(trials):
         print(f"    Trial {i+1}/{trials}...")
-        actual_output_file = run_experiment(executable, output_file)
+        actual_output_file, stdout = run_experiment(executable, output_file)
         if actual_output_file:
              avg_prod, avg_cons = parse_cs_times(actual_output_file)
              prod_list.append(avg_prod)
              cons_list.append(avg_cons)
+             reports.append(parse_latency_report(stdout))
         else:
              print(f"    Trial {i+1} failed for {executable}. Skipping.")
 
@@ -108,6 +180,8 @@ def run_trials(executable, output_file, trials=NUM_TRIALS):
     mean_prod = np.mean(prod_list)
     mean_cons = np.mean(cons_list)
     print(f"  ...done. Avg CS Time: Prod={mean_prod:.4f} ms, Cons={mean_cons:.4f} ms (over {len(prod_list)} successful trials)")
+    if config is not None:
+        record_latency(config, executable, reports)
     return mean_prod, mean_cons
 
 def run_delay_ratio_experiment():
@@ -130,6 +204,8 @@ def run_delay_ratio_experiment():
     sem_cons_times_ms = []
     lock_prod_times_ms = []
     lock_cons_times_ms = []
+    ring_prod_times_ms = []
+    ring_cons_times_ms = []
 
     for r in ratios:
         if r <= 0:
@@ -141,17 +217,22 @@ def run_delay_ratio_experiment():
         print(f"\nRunning for Delay Ratio: mu_p/mu_c = {r} (np={np_val}, nc={nc_val}, cntp={cntp}, cntc={cntc}, mu_p={mu_p} ms [fixed], mu_c={mu_c:.2f} ms [calc])")
         delay_ratios_used.append(r) 
         write_input_file(CAPACITY, np_val, nc_val, cntp, cntc, mu_p, mu_c)
+        config = f"delay ratio {r}"
 
-        avg_sem_prod, avg_sem_cons = run_trials(SEM_EXEC, SEM_OUTPUT, trials=NUM_TRIALS)
+        avg_sem_prod, avg_sem_cons = run_trials(SEM_EXEC, SEM_OUTPUT, trials=NUM_TRIALS, config=config)
         sem_prod_times_ms.append(avg_sem_prod)
         sem_cons_times_ms.append(avg_sem_cons)
 
-        avg_lock_prod, avg_lock_cons = run_trials(LOCK_EXEC, LOCK_OUTPUT, trials=NUM_TRIALS)
+        avg_lock_prod, avg_lock_cons = run_trials(LOCK_EXEC, LOCK_OUTPUT, trials=NUM_TRIALS, config=config)
         lock_prod_times_ms.append(avg_lock_prod)
         lock_cons_times_ms.append(avg_lock_cons)
 
+        avg_ring_prod, avg_ring_cons = run_trials(RING_EXEC, RING_OUTPUT, trials=NUM_TRIALS, config=config)
+        ring_prod_times_ms.append(avg_ring_prod)
+        ring_cons_times_ms.append(avg_ring_cons)
+
     print("--- Experiment 1 Complete ---")
-    return delay_ratios_used, sem_prod_times_ms, sem_cons_times_ms, lock_prod_times_ms, lock_cons_times_ms
+    return delay_ratios_used, sem_prod_times_ms, sem_cons_times_ms, lock_prod_times_ms, lock_cons_times_ms, ring_prod_times_ms, ring_cons_times_ms
 
 def run_thread_ratio_experiment():
     """
@@ -177,6 +258,8 @@ def run_thread_ratio_experiment():
     sem_cons_times_ms = []
     lock_prod_times_ms = []
     lock_cons_times_ms = []
+    ring_prod_times_ms = []
+    ring_cons_times_ms = []
 
     for ratio, np_val, nc_val in configs:
         total_produced = np_val * fixed_cntp
@@ -191,36 +274,42 @@ def run_thread_ratio_experiment():
         print(f"\nRunning for Thread Ratio: np/nc = {ratio} (np={np_val}, nc={nc_val}, cntp={cntp} [fixed], cntc={cntc} [calc], mu_p={mu_p} ms, mu_c={mu_c} ms)")
         ratios.append(ratio)
         write_input_file(CAPACITY, np_val, nc_val, cntp, cntc, mu_p, mu_c)
+        config = f"thread ratio {ratio}"
 
-        avg_sem_prod, avg_sem_cons = run_trials(SEM_EXEC, SEM_OUTPUT, trials=NUM_TRIALS)
+        avg_sem_prod, avg_sem_cons = run_trials(SEM_EXEC, SEM_OUTPUT, trials=NUM_TRIALS, config=config)
         sem_prod_times_ms.append(avg_sem_prod)
         sem_cons_times_ms.append(avg_sem_cons)
 
-        avg_lock_prod, avg_lock_cons = run_trials(LOCK_EXEC, LOCK_OUTPUT, trials=NUM_TRIALS)
+        avg_lock_prod, avg_lock_cons = run_trials(LOCK_EXEC, LOCK_OUTPUT, trials=NUM_TRIALS, config=config)
         lock_prod_times_ms.append(avg_lock_prod)
         lock_cons_times_ms.append(avg_lock_cons)
 
+        avg_ring_prod, avg_ring_cons = run_trials(RING_EXEC, RING_OUTPUT, trials=NUM_TRIALS, config=config)
+        ring_prod_times_ms.append(avg_ring_prod)
+        ring_cons_times_ms.append(avg_ring_cons)
+
     print("--- Experiment 2 Complete ---")
     
    
-    sorted_results = sorted(zip(ratios, sem_prod_times_ms, sem_cons_times_ms, lock_prod_times_ms, lock_cons_times_ms))
+    sorted_results = sorted(zip(ratios, sem_prod_times_ms, sem_cons_times_ms, lock_prod_times_ms, lock_cons_times_ms, ring_prod_times_ms, ring_cons_times_ms))
     if not sorted_results: 
          print("Warning: No valid thread ratio configurations were run.")
-         return [], [], [], [], []
+         return [], [], [], [], [], [], []
          
-    ratios_sorted, sem_prod_sorted, sem_cons_sorted, lock_prod_sorted, lock_cons_sorted = zip(*sorted_results)
+    ratios_sorted, sem_prod_sorted, sem_cons_sorted, lock_prod_sorted, lock_cons_sorted, ring_prod_sorted, ring_cons_sorted = zip(*sorted_results)
     
-    return list(ratios_sorted), list(sem_prod_sorted), list(sem_cons_sorted), list(lock_prod_sorted), list(lock_cons_sorted)
+    return list(ratios_sorted), list(sem_prod_sorted), list(sem_cons_sorted), list(lock_prod_sorted), list(lock_cons_sorted), list(ring_prod_sorted), list(ring_cons_sorted)
 
 
 def plot_comparison_experiment(x_values,
                               sem_prod_times, sem_cons_times,
                               lock_prod_times, lock_cons_times,
+                              ring_prod_times, ring_cons_times,
                               xlabel, title_prefix, filename_prefix):
-    """Plots all four curves (Sem Prod/Cons, Lock Prod/Cons) on a single graph,
+    """Plots all six curves (Sem/Lock/Ring Prod/Cons) on a single graph,
        using a logarithmic scale for the Y-axis to show differences near zero."""
        
-    if not x_values or not any(sem_prod_times + sem_cons_times + lock_prod_times + lock_cons_times): # Check if there's any data at all
+    if not x_values or not any(sem_prod_times + sem_cons_times + lock_prod_times + lock_cons_times + ring_prod_times + ring_cons_times): # Check if there's any data at all
         print(f"No valid data to plot for {title_prefix}.")
         return
 
@@ -240,6 +329,8 @@ def plot_comparison_experiment(x_values,
     safe_log_plot(x_values, sem_cons_times, marker='s', linestyle='-', color='cyan', label='Consumer (Semaphores)')
     safe_log_plot(x_values, lock_prod_times, marker='^', linestyle='--', color='red', label='Producer (Locks)')
     safe_log_plot(x_values, lock_cons_times, marker='x', linestyle='--', color='magenta', label='Consumer (Locks)') 
+    safe_log_plot(x_values, ring_prod_times, marker='D', linestyle=':', color='green', label='Producer (Lock-free ring)')
+    safe_log_plot(x_values, ring_cons_times, marker='v', linestyle=':', color='olive', label='Consumer (Lock-free ring)')
 
     plt.xlabel(xlabel)
     plt.ylabel("Average Critical Section Time (ms) [Log Scale]") 
@@ -247,7 +338,7 @@ def plot_comparison_experiment(x_values,
 
     plt.yscale('log')
 
-    all_positive_times = [t for t in sem_prod_times + sem_cons_times + lock_prod_times + lock_cons_times if t > 0]
+    all_positive_times = [t for t in sem_prod_times + sem_cons_times + lock_prod_times + lock_cons_times + ring_prod_times + ring_cons_times if t > 0]
     if all_positive_times:
          min_val = min(all_positive_times)
          plt.ylim(bottom=min_val * 0.1) 
@@ -270,34 +361,664 @@ def plot_comparison_experiment(x_values,
     plt.savefig(filename)
     print(f"Log scale plot saved to {filename}")
     plt.show()
+
+def run_throughput_trials(executable, output_file, items, extra_args=(), trials=NUM_TRIALS, config=None):
+    """Runs the experiment multiple times and returns (items per second, average handoff latency in ms).
+       The latency is the PROD_CS/CONS_CS span, which in the lock version includes waiting for a slot or an item."""
+    throughputs = []
+    latencies = []
+    reports = []
+    label = " ".join([executable, *extra_args])
+    print(f"  Running {label} ({trials} trials)...")
+    for i in range(trials):
+        start = time.perf_counter()
+        actual_output_file, stdout = run_experiment(executable, output_file, extra_args)
+        elapsed = time.perf_counter() - start - 0.1  # run_experiment sleeps 0.1 s after the run
+        if actual_output_file and elapsed > 0:
+            avg_prod, avg_cons = parse_cs_times(actual_output_file)
+            throughputs.append(items / elapsed)
+            latencies.append((avg_prod + avg_cons) / 2)
+            reports.append(parse_latency_report(stdout))
+        else:
+            print(f"    Trial {i+1} failed for {label}. Skipping.")
+    if not throughputs:
+        return 0, 0
+    mean_tp = np.mean(throughputs)
+    mean_lat = np.mean(latencies)
+    print(f"  ...done. Throughput={mean_tp:.0f} items/s, Avg handoff latency={mean_lat:.4f} ms")
+    if config is not None:
+        record_latency(config, label, reports)
+    return mean_tp, mean_lat
+
+def run_wait_strategy_experiment():
+    """
+    Experiment 3: condition-variable blocking (with and without the adaptive
+    spin) against the original 1 ms sleep polling in the lock version.
+    A small buffer and short delays make threads wait for each other often.
+    """
+    print("\n--- Starting Experiment 3: Lock Version Wait Strategy ---")
+    capacity = 10
+    np_val = 5
+    nc_val = 5
+    cntp = 200
+    cntc = 200
+    delays = [0.0, 0.5, 1.0, 2.0, 5.0]
+    variants = [
+        ("Condition variable + adaptive spin", LOCK_EXEC, ()),
+        ("Condition variable, no spin", LOCK_EXEC, ("--spin=0",)),
+        ("1 ms sleep polling", LOCK_POLL_EXEC, ()),
+    ]
+
+    results = {name: ([], []) for name, _, _ in variants}
+    for mu in delays:
+        print(f"\nRunning for mu_p = mu_c = {mu} ms (capacity={capacity}, np={np_val}, nc={nc_val}, cntp={cntp}, cntc={cntc})")
+        write_input_file(capacity, np_val, nc_val, cntp, cntc, mu, mu)
+        for name, executable, extra_args in variants:
+            tp, lat = run_throughput_trials(executable, LOCK_OUTPUT, np_val * cntp, extra_args, config=f"wait strategy mu {mu}")
+            results[name][0].append(tp)
+            results[name][1].append(lat)
+
+    print("--- Experiment 3 Complete ---")
+    return delays, results
+
+def plot_wait_strategy_experiment(delays, results):
+    """Plots throughput and handoff latency of each wait strategy side by side."""
+    if not delays:
+        print("No valid data to plot for the wait strategy experiment.")
+        return
+    fig, (ax_tp, ax_lat) = plt.subplots(1, 2, figsize=(14, 6))
+    for (name, (throughputs, latencies)), marker in zip(results.items(), ['o', 's', '^']):
+        ax_tp.plot(delays, throughputs, marker=marker, label=name)
+        ax_lat.plot(delays, [l if l > 0 else np.nan for l in latencies], marker=marker, label=name)
+    ax_tp.set_xlabel("Mean delay μp = μc (ms)")
+    ax_tp.set_ylabel("Throughput (items/s)")
+    ax_tp.set_title("Lock Version: Throughput")
+    ax_lat.set_xlabel("Mean delay μp = μc (ms)")
+    ax_lat.set_ylabel("Average handoff latency (ms) [Log Scale]")
+    ax_lat.set_yscale('log')
+    ax_lat.set_title("Lock Version: Wait + CS Time")
+    for ax in (ax_tp, ax_lat):
+        ax.set_xticks(delays)
+        ax.grid(True, which="both", ls="--", alpha=0.6)
+        ax.legend()
+    plt.tight_layout()
+    filename = "wait_strategy_comparison.png"
+    plt.savefig(filename)
+    print(f"Plot saved to {filename}")
+    plt.show()
+
+def run_elastic_pool_experiment():
+    """
+    Experiment 4: fixed consumer pools against the elastic pool of the lock
+    version under bursty arrivals. Every variant runs with --drain so that
+    consumers stop once the producers are done and the buffer is empty;
+    the programs then report consumer thread-seconds (time consumers were
+    active, parked time excluded).
+    Returns a list of (variant, throughput, thread-seconds, p99 ms) rows.
+    """
+    print("\n--- Starting Experiment 4: Elastic Consumer Pool ---")
+    capacity = 50
+    np_val = 4
+    cntp = 100
+    mu_p = 10.0
+    mu_c = 5.0
+    variants = [(f"fixed nc={n}", n, ("--drain",)) for n in (1, 2, 4, 8)]
+    variants.append(("elastic 1-8", 1, ("--elastic=1:8",)))
+
+    rows = []
+    for name, nc_val, extra_args in variants:
+        # cntc only matters without --drain; consumers drain whatever arrives
+        write_input_file(capacity, np_val, nc_val, cntp, cntp, mu_p, mu_c)
+        args = ("--arrival=bursty", *extra_args)
+        throughputs, thread_seconds, p99s = [], [], []
+        print(f"  Running {LOCK_EXEC} {' '.join(args)} with nc={nc_val} ({NUM_TRIALS} trials)...")
+        for i in range(NUM_TRIALS):
+            _, stdout = run_experiment(LOCK_EXEC, LOCK_OUTPUT, args)
+            report = parse_latency_report(stdout)
+            match = re.search(r"Consumer thread-seconds: ([\d.]+)", stdout)
+            if not match or "throughput" not in report:
+                print(f"    Trial {i+1} failed for {name}. Skipping.")
+                continue
+            throughputs.append(report["throughput"])
+            thread_seconds.append(float(match.group(1)))
+            p99s.append(report.get("p99", 0))
+        if throughputs:
+            row = (name, np.mean(throughputs), np.mean(thread_seconds), np.mean(p99s))
+            rows.append(row)
+            print(f"  ...done. Throughput={row[1]:.0f} items/s, thread-seconds={row[2]:.2f}, p99={row[3]:.2f} ms")
+
+    with open(ELASTIC_RESULTS, "w") as f:
+        f.write("variant,throughput_items_per_s,consumer_thread_seconds,p99_ms\n")
+        for name, tp, ts, p99 in rows:
+            f.write(f"{name},{tp:.1f},{ts:.4f},{p99:.6f}\n")
+    print(f"Elastic pool results saved to {ELASTIC_RESULTS}")
+    print("--- Experiment 4 Complete ---")
+    return rows
+
+def plot_elastic_pool_experiment(rows):
+    """Plots throughput against consumer thread-seconds, one point per pool."""
+    if not rows:
+        print("No valid data to plot for the elastic pool experiment.")
+        return
+    fig, ax = plt.subplots(figsize=(8, 6))
+    for name, tp, ts, _ in rows:
+        ax.scatter(ts, tp, marker='*' if name.startswith("elastic") else 'o', s=80)
+        ax.annotate(name, (ts, tp), textcoords="offset points", xytext=(5, 5))
+    ax.set_xlabel("Consumer thread-seconds")
+    ax.set_ylabel("Throughput (items/s)")
+    ax.set_title("Lock Version: Fixed vs Elastic Consumer Pool (bursty arrivals)")
+    ax.grid(True, ls="--", alpha=0.6)
+    plt.tight_layout()
+    filename = "elastic_comparison.png"
+    plt.savefig(filename)
+    print(f"Plot saved to {filename}")
+    plt.show()
+
+def run_elimination_experiment():
+    """
+    Experiment 5: the semaphore version with and without the elimination
+    array under bursty arrivals and fast consumers, so the buffer is mostly
+    empty and consumers are usually waiting when an item arrives.
+    Returns {variant: (p50 list, p99 list)} per producer delay and the share
+    of eliminated items per delay.
+    """
+    print("\n--- Starting Experiment 5: Elimination Handoff ---")
+    capacity = 20
+    np_val = 4
+    nc_val = 4
+    cntp = 200
+    mu_c = 0.2
+    delays = [1.0, 2.0, 5.0, 10.0]
+    variants = [("Buffer only", ("--general",)), ("Elimination array", ("--eliminate",))]
+
+    results = {name: ([], []) for name, _ in variants}
+    shares = []
+    rows = []
+    for mu_p in delays:
+        print(f"\nRunning for mu_p = {mu_p} ms, mu_c = {mu_c} ms (capacity={capacity}, np={np_val}, nc={nc_val}, cntp={cntp})")
+        write_input_file(capacity, np_val, nc_val, cntp, cntp, mu_p, mu_c)
+        for name, extra_args in variants:
+            args = ("--arrival=bursty", *extra_args)
+            p50s, p99s, eliminated = [], [], []
+            for i in range(NUM_TRIALS):
+                _, stdout = run_experiment(SEM_EXEC, SEM_OUTPUT, args)
+                report = parse_latency_report(stdout)
+                if "p50" not in report:
+                    print(f"    Trial {i+1} failed for {name}. Skipping.")
+                    continue
+                p50s.append(report["p50"])
+                p99s.append(report["p99"])
+                match = re.search(r"Eliminated handoffs: \d+ of \d+ items \(([\d.]+)%\)", stdout)
+                if match:
+                    eliminated.append(float(match.group(1)))
+            p50 = np.mean(p50s) if p50s else np.nan
+            p99 = np.mean(p99s) if p99s else np.nan
+            share = np.mean(eliminated) if eliminated else 0.0
+            results[name][0].append(p50)
+            results[name][1].append(p99)
+            rows.append((mu_p, name, p50, p99, share))
+            print(f"  {name}: p50={p50:.4f} ms, p99={p99:.4f} ms" + (f", eliminated {share:.1f}% of items" if eliminated else ""))
+            if eliminated:
+                shares.append(share)
+
+    with open(ELIMINATION_RESULTS, "w") as f:
+        f.write("mu_p,variant,p50_ms,p99_ms,eliminated_percent\n")
+        for mu_p, name, p50, p99, share in rows:
+            f.write(f"{mu_p},{name},{p50:.6f},{p99:.6f},{share:.2f}\n")
+    print(f"Elimination results saved to {ELIMINATION_RESULTS}")
+    print("--- Experiment 5 Complete ---")
+    return delays, results, shares
+
+def plot_elimination_experiment(delays, results, shares):
+    """Plots queueing latency with and without elimination, and how often it happened."""
+    if not delays:
+        print("No valid data to plot for the elimination experiment.")
+        return
+    fig, (ax_lat, ax_share) = plt.subplots(1, 2, figsize=(14, 6))
+    for (name, (p50s, p99s)), marker in zip(results.items(), ['o', 's']):
+        ax_lat.plot(delays, p50s, marker=marker, label=f"{name} p50")
+        ax_lat.plot(delays, p99s, marker=marker, ls="--", label=f"{name} p99")
+    ax_lat.set_xlabel("Mean producer delay μp (ms)")
+    ax_lat.set_ylabel("Queueing latency (ms) [Log Scale]")
+    ax_lat.set_yscale('log')
+    ax_lat.set_title("Semaphore Version: Queueing Latency (bursty arrivals)")
+    ax_share.plot(delays[:len(shares)], shares, marker='o')
+    ax_share.set_xlabel("Mean producer delay μp (ms)")
+    ax_share.set_ylabel("Items handed over directly (%)")
+    ax_share.set_title("Elimination Rate")
+    for ax in (ax_lat, ax_share):
+        ax.set_xticks(delays)
+        ax.grid(True, which="both", ls="--", alpha=0.6)
+    ax_lat.legend()
+    plt.tight_layout()
+    filename = "elimination_comparison.png"
+    plt.savefig(filename)
+    print(f"Plot saved to {filename}")
+    plt.show()
+
+def parse_lane_report(stdout):
+    """
+    Parses the per-lane lines the lock version prints with --lanes=P:
+      Lane <l> queueing latency: samples <n>, p50 <ns> ns, p99 <ns> ns, max <ns> ns
+    Returns {lane: (p50 ms, p99 ms)}.
+    """
+    lanes = {}
+    for match in re.finditer(r"Lane (\d+) queueing latency: samples \d+, p50 (\d+) ns, p99 (\d+) ns", stdout):
+        lanes[int(match.group(1))] = (int(match.group(2)) / 1_000_000.0, int(match.group(3)) / 1_000_000.0)
+    return lanes
+
+def run_priority_lane_experiment():
+    """
+    Experiment 6: three priority lanes in the lock version during overload
+    (producers outpace consumers, so the buffer stays full). Producers send
+    1/7 of their items to lane 0, 2/7 to lane 1 and 4/7 to lane 2; each
+    consumer policy is run with and without aging.
+    Returns (lane numbers, {variant: (p50 list, p99 list)}).
+    """
+    print("\n--- Starting Experiment 6: Priority Lanes ---")
+    capacity = 20
+    np_val = 4
+    nc_val = 2
+    cntp = 150
+    cntc = 300
+    mu_p = 1.0
+    mu_c = 3.0
+    num_lanes = 3
+    variants = [
+        ("Strict", ("--lane-policy=strict", "--aging-ms=0")),
+        ("Strict + aging 50 ms", ("--lane-policy=strict", "--aging-ms=50")),
+        ("Weighted RR", ("--lane-policy=wrr", "--aging-ms=0")),
+        ("Weighted RR + aging 50 ms", ("--lane-policy=wrr", "--aging-ms=50")),
+    ]
+    write_input_file(capacity, np_val, nc_val, cntp, cntc, mu_p, mu_c)
+    lanes = list(range(num_lanes))
+
+    results = {}
+    rows = []
+    for name, extra_args in variants:
+        args = (f"--lanes={num_lanes}", *extra_args)
+        print(f"  Running {LOCK_EXEC} {' '.join(args)} ({NUM_TRIALS} trials)...")
+        reports = []
+        for i in range(NUM_TRIALS):
+            _, stdout = run_experiment(LOCK_EXEC, LOCK_OUTPUT, args)
+            report = parse_lane_report(stdout)
+            if len(report) == num_lanes:
+                reports.append(report)
+            else:
+                print(f"    Trial {i+1} failed for {name}. Skipping.")
+        if not reports:
+            continue
+        p50s = [np.mean([r[l][0] for r in reports]) for l in lanes]
+        p99s = [np.mean([r[l][1] for r in reports]) for l in lanes]
+        results[name] = (p50s, p99s)
+        for l in lanes:
+            rows.append((name, l, p50s[l], p99s[l]))
+            print(f"    lane {l}: p50={p50s[l]:.3f} ms, p99={p99s[l]:.3f} ms")
+
+    with open(LANE_RESULTS, "w") as f:
+        f.write("variant,lane,p50_ms,p99_ms\n")
+        for name, lane, p50, p99 in rows:
+            f.write(f"{name},{lane},{p50:.6f},{p99:.6f}\n")
+    print(f"Priority lane results saved to {LANE_RESULTS}")
+    print("--- Experiment 6 Complete ---")
+    return lanes, results
+
+def plot_priority_lane_experiment(lanes, results):
+    """Plots p50 and p99 queueing latency per lane for each consumer policy."""
+    if not results:
+        print("No valid data to plot for the priority lane experiment.")
+        return
+    fig, (ax_p50, ax_p99) = plt.subplots(1, 2, figsize=(14, 6))
+    for (name, (p50s, p99s)), marker in zip(results.items(), ['o', 's', '^', 'D']):
+        ax_p50.plot(lanes, p50s, marker=marker, label=name)
+        ax_p99.plot(lanes, p99s, marker=marker, label=name)
+    for ax, title in ((ax_p50, "p50"), (ax_p99, "p99")):
+        ax.set_xlabel("Lane (0 = most urgent)")
+        ax.set_ylabel(f"{title} queueing latency (ms) [Log Scale]")
+        ax.set_yscale('log')
+        ax.set_title(f"Lock Version under Overload: {title} per Lane")
+        ax.set_xticks(lanes)
+        ax.grid(True, which="both", ls="--", alpha=0.6)
+        ax.legend()
+    plt.tight_layout()
+    filename = "priority_lanes_comparison.png"
+    plt.savefig(filename)
+    print(f"Plot saved to {filename}")
+    plt.show()
+
+def run_overflow_policy_experiment():
+    """
+    Experiment 7: what the lock version's producers do with a full buffer
+    when they outpace the consumers. Blocking keeps every item but stalls
+    the producers; the other policies shed items to keep queueing latency
+    down. Returns a list of (variant, p99 ms, throughput, shed %) rows.
+    """
+    print("\n--- Starting Experiment 7: Overflow Policies ---")
+    capacity = 10
+    np_val = 4
+    nc_val = 2
+    cntp = 200
+    mu_p = 1.0
+    mu_c = 2.0
+    variants = [
+        ("block", ()),
+        ("block, 2 ms timeout", ("--push-timeout-ms=2",)),
+        ("reject", ("--overflow=reject",)),
+        ("drop-newest", ("--overflow=drop-newest",)),
+        ("drop-oldest", ("--overflow=drop-oldest",)),
+    ]
+    write_input_file(capacity, np_val, nc_val, cntp, np_val * cntp // nc_val, mu_p, mu_c)
+    offered = np_val * cntp
+
+    rows = []
+    for name, extra_args in variants:
+        print(f"  Running {LOCK_EXEC} {' '.join(extra_args)} ({NUM_TRIALS} trials)...")
+        p99s, throughputs, shed = [], [], []
+        for i in range(NUM_TRIALS):
+            _, stdout = run_experiment(LOCK_EXEC, LOCK_OUTPUT, extra_args)
+            report = parse_latency_report(stdout)
+            if "p99" not in report:
+                print(f"    Trial {i+1} failed for {name}. Skipping.")
+                continue
+            p99s.append(report["p99"])
+            throughputs.append(report["throughput"])
+            match = re.search(r"rejected: (\d+), dropped newest: (\d+), dropped oldest: (\d+), timed out: (\d+)", stdout)
+            lost = sum(int(g) for g in match.groups()) if match else 0
+            shed.append(100.0 * lost / offered)
+        if p99s:
+            row = (name, np.mean(p99s), np.mean(throughputs), np.mean(shed))
+            rows.append(row)
+            print(f"  ...done. p99={row[1]:.3f} ms, throughput={row[2]:.0f} items/s, shed {row[3]:.1f}% of items")
+
+    with open(OVERFLOW_RESULTS, "w") as f:
+        f.write("policy,p99_ms,throughput_items_per_s,shed_percent\n")
+        for name, p99, tp, lost in rows:
+            f.write(f"{name},{p99:.6f},{tp:.1f},{lost:.2f}\n")
+    print(f"Overflow policy results saved to {OVERFLOW_RESULTS}")
+    print("--- Experiment 7 Complete ---")
+    return rows
+
+def plot_overflow_policy_experiment(rows):
+    """Plots p99 queueing latency and the share of shed items per policy."""
+    if not rows:
+        print("No valid data to plot for the overflow policy experiment.")
+        return
+    names = [r[0] for r in rows]
+    x = list(range(len(rows)))
+    fig, (ax_lat, ax_shed) = plt.subplots(1, 2, figsize=(14, 6))
+    ax_lat.bar(x, [r[1] for r in rows])
+    ax_lat.set_ylabel("p99 queueing latency (ms)")
+    ax_lat.set_title("Lock Version under Overload: Latency")
+    ax_shed.bar(x, [r[3] for r in rows])
+    ax_shed.set_ylabel("Items rejected, dropped or timed out (%)")
+    ax_shed.set_title("Lock Version under Overload: Shed Load")
+    for ax in (ax_lat, ax_shed):
+        ax.set_xticks(x)
+        ax.set_xticklabels(names, rotation=20)
+        ax.grid(True, axis="y", ls="--", alpha=0.6)
+    plt.tight_layout()
+    filename = "overflow_policy_comparison.png"
+    plt.savefig(filename)
+    print(f"Plot saved to {filename}")
+    plt.show()
+
+def run_with_usage(executable, output_file, extra_args=()):
+    """Runs the executable on inp-params.txt and collects its resource usage.
+       Returns (stdout, peak RSS in KB, context switches), or None if it failed."""
+    if os.path.exists(output_file):
+        os.remove(output_file)
+    try:
+        proc = subprocess.Popen([executable, "inp-params.txt", *extra_args],
+                                stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    except FileNotFoundError:
+        print(f"Error: Executable {executable} not found. Make sure it is compiled and in the current directory.")
+        exit(1)
+    stdout = proc.stdout.read()
+    proc.stdout.close()
+    # wait4 rather than wait so the usage is this child's alone
+    _, status, usage = os.wait4(proc.pid, 0)
+    proc.returncode = os.waitstatus_to_exitcode(status)
+    if proc.returncode != 0:
+        print(f"Error running {executable}: exit status {proc.returncode}")
+        print(stdout.strip())
+        return None
+    return stdout, usage.ru_maxrss, usage.ru_nvcsw + usage.ru_nivcsw
+
+def run_coroutine_experiment():
+    """
+    Experiment 8: one pthread per client (semaphore and lock versions)
+    against coroutines on a worker pool (prod_cons-coro), for growing client
+    counts split evenly between producers and consumers. Records peak
+    memory, context switches and throughput. Returns {program: rows} with
+    rows of (clients, peak RSS MB, context switches, throughput).
+    """
+    print("\n--- Starting Experiment 8: Coroutines vs Threads ---")
+    capacity = 100
+    client_counts = [100, 1000, 5000, 10000]
+    cntp = 10
+    mu_p = 5.0
+    mu_c = 5.0
+    programs = [
+        ("semaphores", SEM_EXEC, SEM_OUTPUT),
+        ("locks", LOCK_EXEC, LOCK_OUTPUT),
+        ("coroutines", CORO_EXEC, CORO_OUTPUT),
+    ]
+
+    results = {name: [] for name, _, _ in programs}
+    for clients in client_counts:
+        half = clients // 2
+        write_input_file(capacity, half, half, cntp, cntp, mu_p, mu_c)
+        for name, executable, output_file in programs:
+            print(f"  Running {executable} with {clients} clients ({NUM_TRIALS} trials)...")
+            rss, switches, throughputs = [], [], []
+            for i in range(NUM_TRIALS):
+                run = run_with_usage(executable, output_file)
+                report = parse_latency_report(run[0]) if run else {}
+                if "throughput" not in report:
+                    print(f"    Trial {i+1} failed for {name}. Skipping.")
+                    continue
+                rss.append(run[1] / 1024.0)
+                switches.append(run[2])
+                throughputs.append(report["throughput"])
+            if rss:
+                row = (clients, np.mean(rss), np.mean(switches), np.mean(throughputs))
+                results[name].append(row)
+                print(f"  ...done. peak RSS {row[1]:.1f} MB, {row[2]:.0f} context switches, {row[3]:.0f} items/s")
+
+    with open(CORO_RESULTS, "w") as f:
+        f.write("program,clients,peak_rss_mb,context_switches,throughput_items_per_s\n")
+        for name, rows in results.items():
+            for clients, mb, cs, tp in rows:
+                f.write(f"{name},{clients},{mb:.2f},{cs:.0f},{tp:.1f}\n")
+    print(f"Coroutine results saved to {CORO_RESULTS}")
+    print("--- Experiment 8 Complete ---")
+    return results
+
+def plot_coroutine_experiment(results):
+    """Plots peak memory and context switches against the number of clients."""
+    if not any(results.values()):
+        print("No valid data to plot for the coroutine experiment.")
+        return
+    fig, (ax_mem, ax_cs) = plt.subplots(1, 2, figsize=(14, 6))
+    for name, rows in results.items():
+        if not rows:
+            continue
+        clients = [r[0] for r in rows]
+        ax_mem.plot(clients, [r[1] for r in rows], marker="o", label=name)
+        ax_cs.plot(clients, [r[2] for r in rows], marker="o", label=name)
+    ax_mem.set_ylabel("Peak RSS (MB)")
+    ax_mem.set_title("Memory per Client Count")
+    ax_cs.set_ylabel("Context switches (voluntary + involuntary)")
+    ax_cs.set_yscale("symlog")
+    ax_cs.set_title("Context Switches per Client Count")
+    for ax in (ax_mem, ax_cs):
+        ax.set_xlabel("Clients (np + nc)")
+        ax.set_xscale("log")
+        ax.legend()
+        ax.grid(True, which="both", ls="--", alpha=0.6)
+    plt.tight_layout()
+    filename = "coroutine_comparison.png"
+    plt.savefig(filename)
+    print(f"Plot saved to {filename}")
+    plt.show()
+
+def run_sim(seed):
+    """Runs the simulator on inp-params.txt with one seed.
+       Returns (avg producer CS ms, avg consumer CS ms, latency report), or None."""
+    output_file, stdout = run_experiment(SIM_EXEC, SIM_OUTPUT, (f"--seed={seed}",), settle=0)
+    if output_file is None:
+        return None
+    avg_prod, avg_cons = parse_cs_times(output_file)
+    return avg_prod, avg_cons, parse_latency_report(stdout)
+
+def run_sim_sweep():
+    """
+    Sweeps mu_p/mu_c and np/nc on the simulator, one seeded run per point,
+    over far more points than the real-time experiments can afford.
+    Same setup as Experiments 1 and 2. Writes every point to sim_sweep.csv.
+    """
+    print("\n--- Starting Simulated Sweeps ---")
+    rows = []
+    start = time.perf_counter()
+
+    fixed_mu_p = 10.0
+    for r in np.logspace(-1, 1, 41):
+        mu_c = fixed_mu_p / r
+        write_input_file(CAPACITY, 5, 5, 100, 100, fixed_mu_p, mu_c)
+        result = run_sim(seed=1)
+        if result:
+            rows.append(("delay", r, 5, 5, fixed_mu_p, mu_c, *result))
+
+    fixed_cntp = 100
+    for np_val in (1, 2, 4, 5, 10):
+        for nc_val in (1, 2, 4, 5, 10):
+            write_input_file(CAPACITY, np_val, nc_val, fixed_cntp, np_val * fixed_cntp // nc_val, 10.0, 10.0)
+            result = run_sim(seed=1)
+            if result:
+                rows.append(("thread", np_val / nc_val, np_val, nc_val, 10.0, 10.0, *result))
+
+    print(f"  {len(rows)} simulated configurations in {time.perf_counter() - start:.2f} s")
+    with open(SIM_RESULTS, "w") as f:
+        f.write("sweep,ratio,np,nc,mu_p,mu_c,prod_cs_ms,cons_cs_ms,p50_ms,p99_ms,throughput_items_per_s\n")
+        for sweep, ratio, np_val, nc_val, mu_p, mu_c, prod, cons, report in rows:
+            f.write(f"{sweep},{ratio:.6g},{np_val},{nc_val},{mu_p},{mu_c:.6g},{prod:.6f},{cons:.6f},"
+                    f"{report.get('p50', 0):.6f},{report.get('p99', 0):.6f},{report.get('throughput', 0):.1f}\n")
+    print(f"Simulated sweep saved to {SIM_RESULTS}")
+    print("--- Simulated Sweeps Complete ---")
+    return rows
+
+def plot_sim_sweep(rows):
+    """Plots the average CS times of both simulated sweeps against their ratio."""
+    if not rows:
+        print("No valid data to plot for the simulated sweeps.")
+        return
+    fig, axes = plt.subplots(1, 2, figsize=(14, 6))
+    for ax, sweep, xlabel in ((axes[0], "delay", "Delay Ratio (μp / μc)"),
+                              (axes[1], "thread", "Thread Number Ratio (np / nc)")):
+        points = sorted((row[1], row[6], row[7]) for row in rows if row[0] == sweep)
+        x = [p[0] for p in points]
+        marker = '.-' if sweep == "delay" else 'o'
+        ax.plot(x, [p[1] if p[1] > 0 else np.nan for p in points], marker, color='blue', label='Producer (simulated)')
+        ax.plot(x, [p[2] if p[2] > 0 else np.nan for p in points], marker, color='cyan', label='Consumer (simulated)')
+        ax.set_xscale('log')
+        ax.set_yscale('log')
+        ax.set_xlabel(xlabel)
+        ax.set_ylabel("Average Critical Section Time (ms) [Log Scale]")
+        ax.set_title(f"Simulated {sweep.capitalize()} Ratio Sweep")
+        ax.grid(True, which="both", ls="--", alpha=0.6)
+        ax.legend()
+    plt.tight_layout()
+    filename = "sim_sweep.png"
+    plt.savefig(filename)
+    print(f"Plot saved to {filename}")
+    plt.show()
+
+def validate_simulator():
+    """
+    Runs the delay ratios of Experiment 1 on both prod_cons-sems and the
+    simulator (NUM_TRIALS seeds) and prints the average CS times and the
+    median queueing latency of each side by side.
+    """
+    print("\n--- Validating the simulator against prod_cons-sems ---")
+    fixed_mu_p = 10.0
+    lines = []
+    for r in [10.0, 5.0, 1.0, 0.5, 0.1]:
+        mu_c = fixed_mu_p / r
+        write_input_file(CAPACITY, 5, 5, 100, 100, fixed_mu_p, mu_c)
+        real_prod, real_cons = run_trials(SEM_EXEC, SEM_OUTPUT, trials=NUM_TRIALS, config=f"validation ratio {r}")
+        real_p50 = latency_rows[-1]["p50_ms"] if latency_rows and latency_rows[-1]["config"] == f"validation ratio {r}" else 0
+        sims = [s for s in (run_sim(seed) for seed in range(1, NUM_TRIALS + 1)) if s]
+        if not sims:
+            continue
+        sim_prod = np.mean([s[0] for s in sims])
+        sim_cons = np.mean([s[1] for s in sims])
+        sim_p50 = np.mean([s[2].get("p50", 0) for s in sims])
+        lines.append((r, real_prod, sim_prod, real_cons, sim_cons, real_p50, sim_p50))
+
+    print(f"\n{'μp/μc':>6} {'prod real':>10} {'prod sim':>10} {'cons real':>10} {'cons sim':>10} {'p50 real':>10} {'p50 sim':>10}  (ms)")
+    for line in lines:
+        print(f"{line[0]:>6} " + " ".join(f"{v:>10.4f}" for v in line[1:]))
+    print("--- Validation Complete ---")
+
 def main():
-    if not os.path.exists(SEM_EXEC) or not os.path.exists(LOCK_EXEC):
-        print(f"Error: Make sure executables '{SEM_EXEC}' and '{LOCK_EXEC}' exist.")
+    if "--sim" in sys.argv[1:]:
+        if not os.path.exists(SIM_EXEC):
+            print(f"Error: Make sure executable '{SIM_EXEC}' exists (make).")
+            return
+        plot_sim_sweep(run_sim_sweep())
+        if os.path.exists(SEM_EXEC):
+            validate_simulator()
+        print("\nSimulated experiments complete.")
+        return
+
+    if not os.path.exists(SEM_EXEC) or not os.path.exists(LOCK_EXEC) or not os.path.exists(RING_EXEC):
+        print(f"Error: Make sure executables '{SEM_EXEC}', '{LOCK_EXEC}' and '{RING_EXEC}' exist.")
         print("Compile the C++ files first (see example commands in script).")
         return
 
     (delay_ratios, sem_prod_delay, sem_cons_delay,
-     lock_prod_delay, lock_cons_delay) = run_delay_ratio_experiment()
+     lock_prod_delay, lock_cons_delay,
+     ring_prod_delay, ring_cons_delay) = run_delay_ratio_experiment()
     plot_comparison_experiment(
         x_values=delay_ratios,
         sem_prod_times=sem_prod_delay, sem_cons_times=sem_cons_delay,
         lock_prod_times=lock_prod_delay, lock_cons_times=lock_cons_delay,
+        ring_prod_times=ring_prod_delay, ring_cons_times=ring_cons_delay,
         xlabel="Delay Ratio (μp / μc)",
         title_prefix="Delay Ratio Experiment",
         filename_prefix="delay_ratio"
     )
 
     (thread_ratios, sem_prod_thread, sem_cons_thread,
-     lock_prod_thread, lock_cons_thread) = run_thread_ratio_experiment()
+     lock_prod_thread, lock_cons_thread,
+     ring_prod_thread, ring_cons_thread) = run_thread_ratio_experiment()
     plot_comparison_experiment(
         x_values=thread_ratios,
         sem_prod_times=sem_prod_thread, sem_cons_times=sem_cons_thread,
         lock_prod_times=lock_prod_thread, lock_cons_times=lock_cons_thread,
+        ring_prod_times=ring_prod_thread, ring_cons_times=ring_cons_thread,
         xlabel="Thread Number Ratio (np / nc)",
         title_prefix="Thread Ratio Experiment",
         filename_prefix="thread_ratio"
     )
 
+    if os.path.exists(LOCK_POLL_EXEC):
+        delays, wait_results = run_wait_strategy_experiment()
+        plot_wait_strategy_experiment(delays, wait_results)
+    else:
+        print(f"\nSkipping the wait strategy experiment: '{LOCK_POLL_EXEC}' not found (make poll).")
+
+    plot_elastic_pool_experiment(run_elastic_pool_experiment())
+    plot_elimination_experiment(*run_elimination_experiment())
+    plot_priority_lane_experiment(*run_priority_lane_experiment())
+    plot_overflow_policy_experiment(run_overflow_policy_experiment())
+    if os.path.exists(CORO_EXEC):
+        plot_coroutine_experiment(run_coroutine_experiment())
+    else:
+        print(f"\nSkipping the coroutine experiment: '{CORO_EXEC}' not found (make coro).")
+
+    save_latency_results()
+
     print("\nAll experiments and plotting complete.")
 
 if __name__ == "__main__":
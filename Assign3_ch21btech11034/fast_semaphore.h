@@ -0,0 +1,180 @@
+#ifndef FAST_SEMAPHORE_H
+#define FAST_SEMAPHORE_H
+
+// Counting semaphore on an atomic counter plus a Linux futex. count holds the
+// free permits, or minus the number of waiters when it is negative. wait() and
+// post() are a single fetch_sub/fetch_add while count stays positive; only a
+// wait that takes count below zero sleeps, and only a post that finds it
+// below zero hands a wakeup to a sleeper through the futex word (one
+// FUTEX_WAKE per sleeper, FUTEX_WAIT only while no wakeup is pending).
+//
+// The sem_init/sem_wait/sem_trywait/sem_post/sem_destroy overloads below take
+// a FastSemaphore * so code written against sem_t switches by changing the
+// type of its semaphores, which is what -DFAST_SEM does in prod_cons-sems.
+//
+// Each semaphore counts its operations and futex calls on a separate cache
+// line from the counter, so fastSemaphoreReport() can say how many syscalls
+// the fast path avoided.
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <string>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+struct FastSemaphoreStats
+{
+    long long waits = 0;
+    long long posts = 0;
+    long long slowWaits = 0; // waits that had to sleep at least once
+    long long futexWaits = 0;
+    long long futexWakes = 0;
+
+    void add(const FastSemaphoreStats &other)
+    {
+        waits += other.waits;
+        posts += other.posts;
+        slowWaits += other.slowWaits;
+        futexWaits += other.futexWaits;
+        futexWakes += other.futexWakes;
+    }
+
+    // Waits and posts that finished without entering the kernel
+    long long syscallsAvoided() const
+    {
+        return (waits - slowWaits) + (posts - futexWakes);
+    }
+};
+
+class FastSemaphore
+{
+public:
+    void init(unsigned value)
+    {
+        count.store(value, std::memory_order_relaxed);
+        wakeups.store(0, std::memory_order_relaxed);
+        counters.waits.store(0, std::memory_order_relaxed);
+        counters.posts.store(0, std::memory_order_relaxed);
+        counters.slowWaits.store(0, std::memory_order_relaxed);
+        counters.futexWaits.store(0, std::memory_order_relaxed);
+        counters.futexWakes.store(0, std::memory_order_relaxed);
+    }
+
+    bool tryWait()
+    {
+        int c = count.load(std::memory_order_relaxed);
+        while (c > 0)
+        {
+            if (count.compare_exchange_weak(c, c - 1, std::memory_order_acquire, std::memory_order_relaxed))
+                return true;
+        }
+        return false;
+    }
+
+    void wait()
+    {
+        counters.waits.fetch_add(1, std::memory_order_relaxed);
+        if (count.fetch_sub(1, std::memory_order_acquire) > 0)
+            return;
+        // Registered as a waiter; sleep until a post() hands over a wakeup.
+        // FUTEX_WAIT returns at once if one arrived after the load.
+        counters.slowWaits.fetch_add(1, std::memory_order_relaxed);
+        for (;;)
+        {
+            int w = wakeups.load(std::memory_order_relaxed);
+            while (w > 0)
+            {
+                if (wakeups.compare_exchange_weak(w, w - 1, std::memory_order_acquire, std::memory_order_relaxed))
+                    return;
+            }
+            counters.futexWaits.fetch_add(1, std::memory_order_relaxed);
+            syscall(SYS_futex, reinterpret_cast<int *>(&wakeups), FUTEX_WAIT_PRIVATE, 0, nullptr, nullptr, 0);
+        }
+    }
+
+    void post()
+    {
+        counters.posts.fetch_add(1, std::memory_order_relaxed);
+        if (count.fetch_add(1, std::memory_order_release) >= 0)
+            return;
+        // A waiter is (about to be) asleep: give it the permit directly
+        counters.futexWakes.fetch_add(1, std::memory_order_relaxed);
+        wakeups.fetch_add(1, std::memory_order_release);
+        syscall(SYS_futex, reinterpret_cast<int *>(&wakeups), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+    }
+
+    FastSemaphoreStats stats() const
+    {
+        FastSemaphoreStats s;
+        s.waits = counters.waits.load(std::memory_order_relaxed);
+        s.posts = counters.posts.load(std::memory_order_relaxed);
+        s.slowWaits = counters.slowWaits.load(std::memory_order_relaxed);
+        s.futexWaits = counters.futexWaits.load(std::memory_order_relaxed);
+        s.futexWakes = counters.futexWakes.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    static_assert(sizeof(std::atomic<int>) == sizeof(int) && std::atomic<int>::is_always_lock_free,
+                  "the futex word is the atomic itself");
+
+    alignas(64) std::atomic<int> count{0};
+    std::atomic<int> wakeups{0};
+
+    struct alignas(64) Counters
+    {
+        std::atomic<long long> waits{0};
+        std::atomic<long long> posts{0};
+        std::atomic<long long> slowWaits{0};
+        std::atomic<long long> futexWaits{0};
+        std::atomic<long long> futexWakes{0};
+    } counters;
+};
+
+inline int sem_init(FastSemaphore *sem, int, unsigned value)
+{
+    if (value > INT_MAX)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    sem->init(value);
+    return 0;
+}
+
+inline int sem_destroy(FastSemaphore *)
+{
+    return 0;
+}
+
+inline int sem_wait(FastSemaphore *sem)
+{
+    sem->wait();
+    return 0;
+}
+
+inline int sem_trywait(FastSemaphore *sem)
+{
+    if (sem->tryWait())
+        return 0;
+    errno = EAGAIN;
+    return -1;
+}
+
+inline int sem_post(FastSemaphore *sem)
+{
+    sem->post();
+    return 0;
+}
+
+// Summary lines for the (summed) stats of one or more semaphores
+inline std::string fastSemaphoreReport(const FastSemaphoreStats &s)
+{
+    return "Semaphore waits: " + std::to_string(s.waits) + ", posts: " + std::to_string(s.posts) +
+           "\nFutex waits: " + std::to_string(s.futexWaits) + ", futex wakes: " + std::to_string(s.futexWakes) +
+           "\nSyscalls avoided: " + std::to_string(s.syscallsAvoided());
+}
+
+#endif
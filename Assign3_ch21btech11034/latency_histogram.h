@@ -0,0 +1,104 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+// Log-linear histogram of nanosecond latencies. Values below 16 ns get a
+// bucket each; above that every power of two is split into 16 buckets, so a
+// percentile is off by at most 1/16 of its value while the whole histogram
+// stays a fixed array. Each consumer thread records into its own instance and
+// the main thread merges them after the join, so nothing here is atomic.
+
+#include <string>
+#include <vector>
+
+class LatencyHistogram
+{
+public:
+    void record(long long ns)
+    {
+        if (ns < 0)
+            ns = 0;
+        buckets[bucketOf(ns)]++;
+        total++;
+        if (ns > maxValue)
+            maxValue = ns;
+    }
+
+    void merge(const LatencyHistogram &other)
+    {
+        for (int b = 0; b < BUCKETS; b++)
+            buckets[b] += other.buckets[b];
+        total += other.total;
+        if (other.maxValue > maxValue)
+            maxValue = other.maxValue;
+    }
+
+    long long count() const
+    {
+        return total;
+    }
+
+    long long max() const
+    {
+        return maxValue;
+    }
+
+    // Upper bound of the bucket holding the p-th percentile (0 < p <= 100),
+    // never more than the largest value recorded
+    long long percentile(double p) const
+    {
+        if (total == 0)
+            return 0;
+        long long rank = static_cast<long long>(p / 100.0 * total + 0.5);
+        if (rank < 1)
+            rank = 1;
+        long long seen = 0;
+        for (int b = 0; b < BUCKETS; b++)
+        {
+            seen += buckets[b];
+            if (seen >= rank)
+                return upperBound(b) < maxValue ? upperBound(b) : maxValue;
+        }
+        return maxValue;
+    }
+
+    // Lines the programs print and experiments.py parses
+    std::vector<std::string> reportLines() const
+    {
+        return {
+            "Queueing latency samples: " + std::to_string(total),
+            "Queueing latency p50: " + std::to_string(percentile(50)) + " ns",
+            "Queueing latency p99: " + std::to_string(percentile(99)) + " ns",
+            "Queueing latency max: " + std::to_string(maxValue) + " ns",
+        };
+    }
+
+    // Bucket layout, also used by the live counters of live_metrics.h
+    static const int SUB_BITS = 4;
+    static const int SUB = 1 << SUB_BITS;
+    static const int BUCKETS = (63 - SUB_BITS + 1) * SUB;
+
+    static int bucketOf(long long v)
+    {
+        if (v < SUB)
+            return static_cast<int>(v);
+        int magnitude = 63 - __builtin_clzll(static_cast<unsigned long long>(v));
+        int sub = static_cast<int>((v >> (magnitude - SUB_BITS)) & (SUB - 1));
+        return (magnitude - SUB_BITS + 1) * SUB + sub;
+    }
+
+    static long long upperBound(int b)
+    {
+        if (b < SUB)
+            return b;
+        int magnitude = b / SUB + SUB_BITS - 1;
+        long long width = 1LL << (magnitude - SUB_BITS);
+        return (static_cast<long long>(SUB + b % SUB) << (magnitude - SUB_BITS)) + width - 1;
+    }
+
+private:
+    long long buckets[BUCKETS] = {};
+    long long total = 0;
+    long long maxValue = 0;
+};
+
+#endif
@@ -0,0 +1,290 @@
+#ifndef LIVE_METRICS_H
+#define LIVE_METRICS_H
+
+// Publishes the state of a running producer-consumer program once per
+// interval, one JSON object per line: queue depth, items enqueued and
+// dequeued (totals and rates over the interval), how many producers and
+// consumers are waiting on the buffer, and the p50/p99 queueing latency of
+// the items dequeued during the interval.
+//
+// Every thread owns a cache-line-aligned block of counters that only it
+// writes, with a relaxed load and store (no read-modify-write), and the
+// sampler thread only reads them, also relaxed. The hot path takes no lock
+// and shares no cache line with another writer. The sampler's view is not a
+// consistent snapshot: counters of different threads are read at slightly
+// different times, so the depth (enqueued minus dequeued) can be off by the
+// items in flight and is clamped at 0.
+//
+// The lines go to a sink:
+//   PATH       JSON-lines file; once it reaches maxBytes it is renamed to
+//              PATH.1 (replacing the previous one) and a new PATH is started
+//   unix:PATH  Unix domain stream socket listening at PATH; every connected
+//              client gets each line. A client that cannot take a line at
+//              once is dropped, so a slow reader never stalls the sampler.
+// A final line is published by stop().
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "latency_histogram.h"
+
+class LiveMetrics
+{
+public:
+    typedef long long (*ClockFn)();
+
+    // Threads [0, producers) are producers, the rest consumers. Throws
+    // std::runtime_error if the sink cannot be opened.
+    LiveMetrics(const std::string &sink, size_t threads, size_t producers, long long intervalMs, ClockFn now,
+                size_t maxBytes = 1 << 20)
+        : counters(threads), producers(producers), intervalMs(std::max(1LL, intervalMs)), now(now), maxBytes(maxBytes)
+    {
+        if (sink.rfind("unix:", 0) == 0)
+            openSocket(sink.substr(5));
+        else
+        {
+            path = sink;
+            file.open(path, std::ios::out | std::ios::trunc);
+            if (!file)
+                throw std::runtime_error("cannot open " + path);
+        }
+        last.resize(LatencyHistogram::BUCKETS, 0);
+        lastTime = now();
+        sampler = std::thread(&LiveMetrics::run, this);
+    }
+
+    ~LiveMetrics()
+    {
+        stop();
+    }
+
+    LiveMetrics(const LiveMetrics &) = delete;
+    LiveMetrics &operator=(const LiveMetrics &) = delete;
+
+    // Thread t put n items into the buffer
+    void enqueued(size_t t, long long n = 1)
+    {
+        bump(counters[t].enqueued, n);
+    }
+
+    // Thread t took an item out that waited latencyNs
+    void dequeued(size_t t, long long latencyNs)
+    {
+        Counters &c = counters[t];
+        bump(c.dequeued, 1);
+        bump(c.latency[LatencyHistogram::bucketOf(std::max(0LL, latencyNs))], 1);
+    }
+
+    // Thread t starts (true) or stops (false) waiting for space or items
+    void blocked(size_t t, bool waiting)
+    {
+        counters[t].blocked.store(waiting, std::memory_order_relaxed);
+    }
+
+    // Publishes a last sample and closes the sink
+    void stop()
+    {
+        if (!sampler.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stopping = true;
+        }
+        wake.notify_one();
+        sampler.join();
+        file.close();
+        for (int fd : clients)
+            ::close(fd);
+        clients.clear();
+        if (listener >= 0)
+        {
+            ::close(listener);
+            ::unlink(socketPath.c_str());
+            listener = -1;
+        }
+    }
+
+    long long samples() const
+    {
+        return published;
+    }
+
+private:
+    struct alignas(64) Counters
+    {
+        std::atomic<long long> enqueued{0};
+        std::atomic<long long> dequeued{0};
+        std::atomic<bool> blocked{false};
+        std::atomic<long long> latency[LatencyHistogram::BUCKETS] = {};
+    };
+
+    // Single writer, so a plain load and store is enough and cheaper than fetch_add
+    static void bump(std::atomic<long long> &a, long long n)
+    {
+        a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    void openSocket(const std::string &p)
+    {
+        sockaddr_un addr{};
+        if (p.size() >= sizeof(addr.sun_path))
+            throw std::runtime_error("socket path too long: " + p);
+        addr.sun_family = AF_UNIX;
+        std::strcpy(addr.sun_path, p.c_str());
+        listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listener < 0)
+            throw std::runtime_error("cannot create socket for " + p);
+        ::unlink(p.c_str());
+        if (::bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || ::listen(listener, 8) != 0)
+        {
+            ::close(listener);
+            listener = -1;
+            throw std::runtime_error("cannot listen on " + p);
+        }
+        socketPath = p;
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(m);
+        for (;;)
+        {
+            bool last = wake.wait_for(lock, std::chrono::milliseconds(intervalMs), [this]
+                                      { return stopping; });
+            lock.unlock();
+            publish(sample());
+            lock.lock();
+            if (last)
+                return;
+        }
+    }
+
+    std::string sample()
+    {
+        long long t = now();
+        long long enq = 0, deq = 0;
+        int blockedProducers = 0, blockedConsumers = 0;
+        std::vector<long long> buckets(LatencyHistogram::BUCKETS, 0);
+        for (size_t i = 0; i < counters.size(); i++)
+        {
+            const Counters &c = counters[i];
+            enq += c.enqueued.load(std::memory_order_relaxed);
+            deq += c.dequeued.load(std::memory_order_relaxed);
+            if (c.blocked.load(std::memory_order_relaxed))
+                (i < producers ? blockedProducers : blockedConsumers)++;
+            for (int b = 0; b < LatencyHistogram::BUCKETS; b++)
+                buckets[b] += c.latency[b].load(std::memory_order_relaxed);
+        }
+
+        // Latency of the items dequeued since the last sample
+        long long interval = 0;
+        for (int b = 0; b < LatencyHistogram::BUCKETS; b++)
+        {
+            long long total = buckets[b];
+            buckets[b] = total - last[b];
+            last[b] = total;
+            interval += buckets[b];
+        }
+        double seconds = std::max(t - lastTime, 1LL) / 1e9;
+
+        std::ostringstream oss;
+        oss << "{\"t_ms\":" << t / 1000000
+            << ",\"depth\":" << std::max(enq - deq, 0LL)
+            << ",\"enqueued\":" << enq
+            << ",\"dequeued\":" << deq
+            << ",\"enqueue_rate\":" << static_cast<long long>((enq - lastEnqueued) / seconds)
+            << ",\"dequeue_rate\":" << static_cast<long long>((deq - lastDequeued) / seconds)
+            << ",\"blocked_producers\":" << blockedProducers
+            << ",\"blocked_consumers\":" << blockedConsumers
+            << ",\"latency_samples\":" << interval
+            << ",\"latency_p50_ns\":" << percentile(buckets, interval, 50)
+            << ",\"latency_p99_ns\":" << percentile(buckets, interval, 99) << "}\n";
+        lastTime = t;
+        lastEnqueued = enq;
+        lastDequeued = deq;
+        return oss.str();
+    }
+
+    // Upper bound of the bucket holding the p-th percentile, "null" when empty
+    static std::string percentile(const std::vector<long long> &buckets, long long total, double p)
+    {
+        if (total == 0)
+            return "null";
+        long long rank = static_cast<long long>(p / 100.0 * total + 0.5);
+        rank = std::min(std::max(rank, 1LL), total);
+        long long seen = 0;
+        for (int b = 0; b < LatencyHistogram::BUCKETS; b++)
+        {
+            seen += buckets[b];
+            if (seen >= rank)
+                return std::to_string(LatencyHistogram::upperBound(b));
+        }
+        return "null";
+    }
+
+    void publish(const std::string &line)
+    {
+        published++;
+        if (listener < 0)
+        {
+            file << line << std::flush;
+            if (static_cast<size_t>(file.tellp()) >= maxBytes)
+            {
+                file.close();
+                std::rename(path.c_str(), (path + ".1").c_str());
+                file.open(path, std::ios::out | std::ios::trunc);
+            }
+            return;
+        }
+        for (int fd; (fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0;)
+            clients.push_back(fd);
+        for (size_t i = 0; i < clients.size();)
+        {
+            ssize_t sent = ::send(clients[i], line.data(), line.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (sent == static_cast<ssize_t>(line.size()))
+            {
+                i++;
+                continue;
+            }
+            // Gone, or too slow to take a whole line
+            ::close(clients[i]);
+            clients.erase(clients.begin() + i);
+        }
+    }
+
+    std::vector<Counters> counters;
+    const size_t producers;
+    const long long intervalMs;
+    const ClockFn now;
+    const size_t maxBytes;
+
+    // Sampler thread only
+    std::vector<long long> last;
+    long long lastTime = 0, lastEnqueued = 0, lastDequeued = 0;
+    long long published = 0;
+    std::string path;
+    std::ofstream file;
+    std::string socketPath;
+    int listener = -1;
+    std::vector<int> clients;
+
+    std::mutex m;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread sampler;
+};
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef LOG_DRAIN_H
+#define LOG_DRAIN_H
+
+// Streams log records to a file while the program runs, in time order and
+// in fixed memory. Each thread pushes binary records into its own SPSC ring
+// (spsc_ring.h); a background writer thread merges the rings by record time
+// and formats the records into the file. Nothing grows with the length of
+// the run: when a thread's ring is full it waits for the writer.
+//
+// The writer may only write a record once no thread can still push an
+// older one. A thread therefore brackets each group of pushes with
+// begin()/end(): begin() publishes a time no later than any record it is
+// about to push, end() withdraws it. The writer reads the clock, then every
+// thread's published time, and writes the records up to the smallest of
+// them. A thread outside begin()/end() publishes nothing; its next begin()
+// reads the clock after the writer's read, so its records come later anyway.
+// Between begin() and end() a thread must not wait for other threads (only
+// for the writer, in push()), or it would hold the writer back. A thread
+// that finds its ring full moves its published time up to the record it is
+// pushing, so a group of records larger than the ring still drains.
+//
+// Record needs a long long member time (ns, from the same clock as now) and
+// records of one thread must be pushed in nondecreasing time order, none
+// older than the clock at its begin().
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "spsc_ring.h"
+
+template <typename Record>
+class LogDrain
+{
+public:
+    typedef void (*WriteFn)(std::ostream &, const Record &);
+    typedef long long (*ClockFn)();
+
+    // Truncates path and starts the writer. Throws std::runtime_error if the
+    // file cannot be opened.
+    LogDrain(const std::string &path, size_t threads, size_t ringCapacity, WriteFn write, ClockFn now)
+        : out(path, std::ios::out | std::ios::trunc), write(write), now(now), lanes(threads)
+    {
+        if (!out)
+            throw std::runtime_error("cannot open " + path);
+        for (Lane &l : lanes)
+        {
+            l.ring.reset(new SpscRing<Record>(ringCapacity));
+            l.since.store(IDLE, std::memory_order_relaxed);
+        }
+        writer = std::thread(&LogDrain::run, this);
+    }
+
+    ~LogDrain()
+    {
+        close();
+    }
+
+    LogDrain(const LogDrain &) = delete;
+    LogDrain &operator=(const LogDrain &) = delete;
+
+    // Thread t is about to push records with time >= the clock from now on
+    void begin(size_t t)
+    {
+        std::atomic<long long> &since = lanes[t].since;
+        // Hold the writer back until the real time is published
+        since.store(0, std::memory_order_seq_cst);
+        since.store(now(), std::memory_order_seq_cst);
+    }
+
+    // Between begin(t) and end(t) only; waits while thread t's ring is full
+    void push(size_t t, const Record &r)
+    {
+        Lane &l = lanes[t];
+        size_t pos;
+        if (l.ring->tryPush(r, pos))
+            return;
+        l.fullWaits++;
+        // No older record can follow r from this thread, so the writer may
+        // go up to r; otherwise a group larger than the ring never drains
+        l.since.store(r.time, std::memory_order_seq_cst);
+        while (!l.ring->tryPush(r, pos))
+            std::this_thread::yield();
+    }
+
+    void end(size_t t)
+    {
+        lanes[t].since.store(IDLE, std::memory_order_seq_cst);
+    }
+
+    // Writes out everything left and stops the writer; all threads must have
+    // finished pushing. Called by the destructor if not before.
+    void close()
+    {
+        if (!writer.joinable())
+            return;
+        stopping.store(true, std::memory_order_release);
+        writer.join();
+        out.flush();
+    }
+
+    long long recordsWritten() const
+    {
+        return written;
+    }
+
+    // Times a thread found its ring full and had to wait for the writer
+    long long fullWaits() const
+    {
+        long long n = 0;
+        for (const Lane &l : lanes)
+            n += l.fullWaits;
+        return n;
+    }
+
+    // Records the rings can hold at once, all threads together
+    size_t ringRecords() const
+    {
+        return lanes.size() * lanes[0].ring->capacity();
+    }
+
+private:
+    static const long long IDLE = LLONG_MAX;
+
+    struct Lane
+    {
+        std::unique_ptr<SpscRing<Record>> ring;
+        alignas(64) std::atomic<long long> since;
+        long long fullWaits = 0; // owner thread only, read after close()
+        // Writer only: the ring's next record, already taken out of it
+        Record head;
+        bool hasHead = false;
+    };
+
+    void run()
+    {
+        for (;;)
+        {
+            bool last = stopping.load(std::memory_order_acquire);
+            long long limit = now();
+            for (Lane &l : lanes)
+                limit = std::min(limit, l.since.load(std::memory_order_seq_cst));
+            if (last)
+                limit = IDLE;
+
+            long long before = written;
+            for (;;)
+            {
+                Lane *next = nullptr;
+                for (Lane &l : lanes)
+                {
+                    size_t pos;
+                    if (!l.hasHead)
+                        l.hasHead = l.ring->tryPop(l.head, pos);
+                    if (l.hasHead && (!next || l.head.time < next->head.time))
+                        next = &l;
+                }
+                if (!next || next->head.time > limit)
+                    break;
+                write(out, next->head);
+                out << '\n';
+                next->hasHead = false;
+                written++;
+            }
+            if (last)
+                return;
+            if (written == before)
+                std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+    }
+
+    std::ofstream out;
+    const WriteFn write;
+    const ClockFn now;
+    std::vector<Lane> lanes;
+    std::atomic<bool> stopping{false};
+    long long written = 0;
+    std::thread writer;
+};
+
+#endif
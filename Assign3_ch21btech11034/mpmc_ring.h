@@ -0,0 +1,128 @@
+#ifndef MPMC_RING_H
+#define MPMC_RING_H
+
+// Bounded multi-producer multi-consumer ring with a sequence number per slot
+// (D. Vyukov's design). A producer claims a position with one CAS on the
+// enqueue counter, writes the item and publishes it by bumping the slot's
+// sequence; consumers do the same on the dequeue counter. There is no lock,
+// so tryPush/tryPop never block: they return false when the ring is full or
+// empty and the caller decides how to wait.
+//
+// Slot s holds sequence pos when it is free for the producer of position pos,
+// and pos + 1 once that item is ready for the consumer of position pos. The
+// counters are 64-bit and only ever grow, so any capacity of at least 2 works
+// (the slot is pos % capacity) and wrap-around is not a concern. With one
+// slot, "ready for pos" and "free for pos + 1" would be the same sequence.
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+template <typename T>
+class MpmcRing
+{
+public:
+    explicit MpmcRing(size_t capacity) : cap(capacity), cells(capacity)
+    {
+        for (size_t i = 0; i < cap; i++)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    MpmcRing(const MpmcRing &) = delete;
+    MpmcRing &operator=(const MpmcRing &) = delete;
+
+    size_t capacity() const
+    {
+        return cap;
+    }
+
+    // Items in the ring at some recent moment; only a hint while other
+    // threads are pushing or popping
+    size_t sizeApprox() const
+    {
+        unsigned long long out = dequeuePos.load(std::memory_order_relaxed);
+        unsigned long long in = enqueuePos.load(std::memory_order_relaxed);
+        return in > out ? static_cast<size_t>(in - out) : 0;
+    }
+
+    // On success pos is the slot the item went into
+    bool tryPush(const T &item, size_t &pos)
+    {
+        unsigned long long ticket = enqueuePos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = cells[ticket % cap];
+            unsigned long long seq = cell.sequence.load(std::memory_order_acquire);
+            long long diff = (long long)(seq - ticket);
+            if (diff == 0)
+            {
+                // Slot is free for this ticket; on failure ticket is reloaded
+                if (enqueuePos.compare_exchange_weak(ticket, ticket + 1, std::memory_order_relaxed))
+                {
+                    cell.value = item;
+                    cell.sequence.store(ticket + 1, std::memory_order_release);
+                    pos = ticket % cap;
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                // The consumer of the previous lap has not freed the slot: full
+                return false;
+            }
+            else
+            {
+                // Another producer already took this ticket
+                ticket = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // On success pos is the slot the item came from
+    bool tryPop(T &item, size_t &pos)
+    {
+        unsigned long long ticket = dequeuePos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = cells[ticket % cap];
+            unsigned long long seq = cell.sequence.load(std::memory_order_acquire);
+            long long diff = (long long)(seq - (ticket + 1));
+            if (diff == 0)
+            {
+                if (dequeuePos.compare_exchange_weak(ticket, ticket + 1, std::memory_order_relaxed))
+                {
+                    item = cell.value;
+                    // Hand the slot to the producer of the next lap
+                    cell.sequence.store(ticket + cap, std::memory_order_release);
+                    pos = ticket % cap;
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                // The producer of this ticket has not published yet: empty
+                return false;
+            }
+            else
+            {
+                ticket = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    // Each slot and each counter gets its own cache line so producers and
+    // consumers working on neighbouring slots do not invalidate each other
+    struct alignas(64) Cell
+    {
+        std::atomic<unsigned long long> sequence;
+        T value;
+    };
+
+    const size_t cap;
+    std::vector<Cell> cells;
+    alignas(64) std::atomic<unsigned long long> enqueuePos{0};
+    alignas(64) std::atomic<unsigned long long> dequeuePos{0};
+};
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef MULTICAST_RING_H
+#define MULTICAST_RING_H
+
+// Bounded ring in which every item is seen by each of G consumer groups (in
+// the style of the LMAX Disruptor), instead of by exactly one consumer. All
+// groups read the same slots; each group only keeps a cursor, the sequence of
+// the next item it has not finished with. A slot is reused only once the
+// slowest group's cursor has passed it, so a group that falls behind holds
+// the producers back rather than missing items.
+//
+// Producers claim sequence numbers with a CAS on one counter, write the slot
+// and publish it by storing its sequence in the slot. Each group is read by
+// one consumer thread, which can take every item published so far in one go
+// (consume) and moves its cursor once per batch. Nothing blocks: tryPush
+// returns false while the slowest group is a full lap behind and consume
+// returns 0 when nothing new is published, and the caller decides how to wait.
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+template <typename T>
+class MulticastRing
+{
+public:
+    MulticastRing(size_t capacity, size_t groups) : cap(capacity), cells(capacity), cursors(groups)
+    {
+        for (Cell &cell : cells)
+            cell.published.store(NONE, std::memory_order_relaxed);
+        for (Cursor &c : cursors)
+            c.next.store(0, std::memory_order_relaxed);
+    }
+
+    MulticastRing(const MulticastRing &) = delete;
+    MulticastRing &operator=(const MulticastRing &) = delete;
+
+    size_t capacity() const
+    {
+        return cap;
+    }
+
+    size_t groups() const
+    {
+        return cursors.size();
+    }
+
+    // Any number of producers; on success pos is the slot the item went into
+    bool tryPush(const T &item, size_t &pos)
+    {
+        unsigned long long seq = claimed.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            // seq may be stale and behind the gate, hence the signed compare
+            if ((long long)(seq - cachedGate.load(std::memory_order_acquire)) >= (long long)cap)
+            {
+                // Looks full against the last known slowest group; look again
+                unsigned long long gate = slowestCursor();
+                cachedGate.store(gate, std::memory_order_release);
+                if ((long long)(seq - gate) >= (long long)cap)
+                    return false;
+            }
+            if (claimed.compare_exchange_weak(seq, seq + 1, std::memory_order_relaxed))
+                break;
+        }
+        Cell &cell = cells[seq % cap];
+        cell.value = item;
+        cell.published.store(seq, std::memory_order_release);
+        pos = seq % cap;
+        return true;
+    }
+
+    // Group g's consumer only: calls f(item, seq) for up to maxItems items,
+    // in sequence order, that the group has not seen yet, then releases them
+    // all at once. Returns how many were handled.
+    template <typename F>
+    size_t consume(size_t g, size_t maxItems, F &&f)
+    {
+        std::atomic<unsigned long long> &cursor = cursors[g].next;
+        unsigned long long first = cursor.load(std::memory_order_relaxed);
+        unsigned long long seq = first;
+        while (seq - first < maxItems)
+        {
+            const Cell &cell = cells[seq % cap];
+            if (cell.published.load(std::memory_order_acquire) != seq)
+                break;
+            f(cell.value, seq);
+            seq++;
+        }
+        if (seq != first)
+            cursor.store(seq, std::memory_order_release);
+        return static_cast<size_t>(seq - first);
+    }
+
+    // One item for group g; on success pos is the slot it came from
+    bool tryPop(size_t g, T &item, size_t &pos)
+    {
+        return consume(g, 1, [&](const T &value, unsigned long long seq)
+                       {
+                           item = value;
+                           pos = seq % cap;
+                       }) == 1;
+    }
+
+private:
+    static const unsigned long long NONE = ~0ULL;
+
+    unsigned long long slowestCursor() const
+    {
+        unsigned long long slowest = NONE;
+        for (const Cursor &c : cursors)
+        {
+            unsigned long long next = c.next.load(std::memory_order_acquire);
+            if (next < slowest)
+                slowest = next;
+        }
+        return slowest;
+    }
+
+    // The sequence a slot was last published for sits next to the item so a
+    // reader checks and reads one cache line
+    struct alignas(64) Cell
+    {
+        std::atomic<unsigned long long> published;
+        T value;
+    };
+
+    struct alignas(64) Cursor
+    {
+        std::atomic<unsigned long long> next;
+    };
+
+    const size_t cap;
+    std::vector<Cell> cells;
+    std::vector<Cursor> cursors;
+    alignas(64) std::atomic<unsigned long long> claimed{0};
+    // Producers' view of the slowest cursor. A stale (smaller) value is only
+    // conservative: it sends the producer to look at the cursors again.
+    // Acquire/release so a producer that trusts it also sees the reads the
+    // consumers finished before moving their cursors.
+    std::atomic<unsigned long long> cachedGate{0};
+};
+
+#endif
@@ -0,0 +1,194 @@
+#ifndef PACING_H
+#define PACING_H
+
+// Nanosecond pacing for producer arrivals and consumer delays. Delays are
+// drawn in nanoseconds and slept towards an absolute deadline: the thread
+// sleeps with sleep_until until PACING_SPIN_NS before the deadline and then
+// yields in a loop for the rest, so neither the timer slack of the kernel nor
+// truncation to whole milliseconds distorts sub-millisecond delays.
+//
+// Three processes, all with mean gap meanMs:
+//
+//   exp         exponential gaps (Poisson arrivals), the assignment's model
+//   const       every gap exactly meanMs
+//   bursty      on/off: ON and OFF periods are exponential with means onMs
+//               and offMs; arrivals are Poisson during ON and absent during
+//               OFF, at a rate chosen so the long-run mean gap is still meanMs
+//
+// nextArrival() keeps an open-loop schedule: each deadline is the previous
+// deadline plus the next gap, so time spent blocked on the buffer is not added
+// to the gaps and a producer that fell behind catches up. delay() starts from
+// now, which is what a consumer's processing time is.
+
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+enum class ArrivalMode
+{
+    Exponential,
+    Constant,
+    Bursty
+};
+
+struct ArrivalProcess
+{
+    ArrivalMode mode = ArrivalMode::Exponential;
+    // Bursty only. Without ON:OFF (onMs 0) both default to 10 mean gaps; a
+    // given OFF of 0 means no OFF phase, i.e. Poisson arrivals
+    double onMs = 0;
+    double offMs = 0;
+};
+
+// Parses "exp", "const", "bursty" or "bursty:ON_MS:OFF_MS"
+inline bool parseArrivalProcess(const std::string &spec, ArrivalProcess &out)
+{
+    ArrivalProcess p;
+    if (spec == "exp")
+        p.mode = ArrivalMode::Exponential;
+    else if (spec == "const")
+        p.mode = ArrivalMode::Constant;
+    else if (spec.rfind("bursty", 0) == 0)
+    {
+        p.mode = ArrivalMode::Bursty;
+        if (spec.size() > 6)
+        {
+            size_t colon = spec.find(':', 7);
+            if (spec[6] != ':' || colon == std::string::npos)
+                return false;
+            try
+            {
+                p.onMs = std::stod(spec.substr(7, colon - 7));
+                p.offMs = std::stod(spec.substr(colon + 1));
+            }
+            catch (const std::exception &)
+            {
+                return false;
+            }
+            if (p.onMs <= 0 || p.offMs < 0)
+                return false;
+        }
+    }
+    else
+        return false;
+    out = p;
+    return true;
+}
+
+// Final stretch before a deadline that is spun instead of slept
+const long long PACING_SPIN_NS = 60000;
+
+inline void sleepUntilPrecise(std::chrono::steady_clock::time_point deadline)
+{
+    auto coarse = deadline - std::chrono::nanoseconds(PACING_SPIN_NS);
+    if (std::chrono::steady_clock::now() < coarse)
+        std::this_thread::sleep_until(coarse);
+    while (std::chrono::steady_clock::now() < deadline)
+        std::this_thread::yield();
+}
+
+// One per thread
+class Pacer
+{
+public:
+    Pacer(const ArrivalProcess &process, double meanMs, unsigned seed)
+        : process(process), meanNs(meanMs * 1e6), generator(seed), next(std::chrono::steady_clock::now())
+    {
+        if (process.mode == ArrivalMode::Bursty)
+        {
+            // The parser only accepts ON:OFF with ON > 0, so onMs tells
+            // whether they were given; an OFF of 0 is then kept as is
+            bool given = process.onMs > 0;
+            double onNs = given ? process.onMs * 1e6 : 10 * meanNs;
+            double offNs = given ? process.offMs * 1e6 : 10 * meanNs;
+            // All arrivals fall into the ON share of the time
+            burstGapNs = meanNs * onNs / (onNs + offNs);
+            onDist = std::exponential_distribution<double>(1.0 / onNs);
+            offDist = std::exponential_distribution<double>(offNs > 0 ? 1.0 / offNs : 1.0);
+            offMeanNs = offNs;
+            onLeftNs = onDist(generator);
+        }
+    }
+
+    // Sum of the next n gaps, in nanoseconds
+    long long gapNs(int n = 1)
+    {
+        double total = 0;
+        for (int i = 0; i < n; i++)
+            total += gap();
+        return static_cast<long long>(total);
+    }
+
+    // Open loop: waits until the arrival time of the item n gaps after the last one
+    void nextArrival(int n = 1)
+    {
+        sleepUntilPrecise(arrivalDeadline(n));
+    }
+
+    // Closed loop: waits n gaps from now
+    void delay(int n = 1)
+    {
+        sleepUntilPrecise(delayDeadline(n));
+    }
+
+    // As nextArrival() and delay(), but only return the deadline, for callers
+    // that wait for it some other way (the coroutine version)
+    std::chrono::steady_clock::time_point arrivalDeadline(int n = 1)
+    {
+        next += std::chrono::nanoseconds(gapNs(n));
+        return next;
+    }
+
+    std::chrono::steady_clock::time_point delayDeadline(int n = 1)
+    {
+        next = std::chrono::steady_clock::now() + std::chrono::nanoseconds(gapNs(n));
+        return next;
+    }
+
+private:
+    double gap()
+    {
+        if (meanNs <= 0)
+            return 0;
+        switch (process.mode)
+        {
+        case ArrivalMode::Constant:
+            return meanNs;
+        case ArrivalMode::Bursty:
+        {
+            // Gaps are memoryless, so one that runs past the end of the ON
+            // period continues, after an OFF period, as a fresh one
+            double total = 0;
+            for (;;)
+            {
+                double g = expDist(generator) * burstGapNs;
+                if (g <= onLeftNs)
+                {
+                    onLeftNs -= g;
+                    return total + g;
+                }
+                total += onLeftNs + (offMeanNs > 0 ? offDist(generator) : 0);
+                onLeftNs = onDist(generator);
+            }
+        }
+        default:
+            return expDist(generator) * meanNs;
+        }
+    }
+
+    const ArrivalProcess process;
+    const double meanNs;
+    std::mt19937_64 generator;
+    std::exponential_distribution<double> expDist{1.0}; // unit mean, scaled
+    std::chrono::steady_clock::time_point next;
+
+    double burstGapNs = 0;
+    double offMeanNs = 0;
+    double onLeftNs = 0;
+    std::exponential_distribution<double> onDist;
+    std::exponential_distribution<double> offDist;
+};
+
+#endif
@@ -0,0 +1,226 @@
+#ifndef PRIORITY_LANES_H
+#define PRIORITY_LANES_H
+
+// Storage of a bounded buffer split into P priority lanes (lane 0 is the
+// most urgent) that share one capacity budget. Each lane is a FIFO ring, so
+// items of equal priority keep their order; which lane the next pop serves
+// is the policy's choice:
+//
+//   Strict              always the most urgent non-empty lane
+//   WeightedRoundRobin  lanes take turns, lane l serving up to 2^(P-1-l)
+//                       items per turn, so bulk lanes keep a share of the
+//                       consumers during overload
+//
+// With aging, a lane whose oldest item has waited at least agingNs is served
+// first whatever its priority, which bounds how long strict priority can
+// starve a lane. Nothing here is synchronized: the caller holds the buffer
+// lock, as prod_cons-locks does around its ring indices.
+
+#include <cstddef>
+#include <vector>
+
+enum class LanePolicy
+{
+    Strict,
+    WeightedRoundRobin
+};
+
+template <typename T>
+class PriorityLanes
+{
+public:
+    // At most MAX_LANES lanes; agingNs <= 0 turns aging off
+    static const size_t MAX_LANES = 8;
+
+    PriorityLanes(size_t lanes, size_t capacity, LanePolicy policy, long long agingNs)
+        : cap(capacity), policy(policy), agingNs(agingNs), queues(lanes < 1 ? 1 : lanes > MAX_LANES ? MAX_LANES : lanes)
+    {
+        for (Lane &q : queues)
+            q.slots.resize(capacity);
+        credit = weight(0);
+    }
+
+    size_t lanes() const
+    {
+        return queues.size();
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    size_t size(size_t lane) const
+    {
+        return queues[lane].count;
+    }
+
+    bool full() const
+    {
+        return count >= cap;
+    }
+
+    // Pops that served a lane because its oldest item had aged
+    long long agedPops() const
+    {
+        return aged;
+    }
+
+    // Appends item to the given lane; the buffer must not be full. Returns
+    // the item's position within its lane.
+    size_t push(const T &item, size_t lane, long long nowNs)
+    {
+        Lane &q = queues[lane];
+        size_t pos = q.tail;
+        q.slots[pos] = Entry{item, nowNs};
+        q.tail = (q.tail + 1) % cap;
+        q.count++;
+        count++;
+        return pos;
+    }
+
+    // Removes the oldest item in any lane, for a drop-oldest overflow policy;
+    // the buffer must not be empty. Returns its position in its lane.
+    size_t dropOldest(T &item, size_t &lane)
+    {
+        lane = oldestLane();
+        return take(lane, item);
+    }
+
+    // Removes the item pushed last in any lane, for a drop-newest overflow
+    // policy; the buffer must not be empty. Returns its position in its lane.
+    size_t dropNewest(T &item, size_t &lane)
+    {
+        lane = newestLane();
+        Lane &q = queues[lane];
+        q.tail = (q.tail + cap - 1) % cap;
+        item = q.slots[q.tail].item;
+        q.count--;
+        count--;
+        return q.tail;
+    }
+
+    // Removes the item the policy picks next; the buffer must not be empty.
+    // lane is set to the lane it came from. Returns its position in the lane.
+    size_t pop(long long nowNs, T &item, size_t &lane)
+    {
+        lane = pick(nowNs);
+        return take(lane, item);
+    }
+
+private:
+    struct Entry
+    {
+        T item;
+        long long enqueued;
+    };
+
+    struct Lane
+    {
+        std::vector<Entry> slots;
+        size_t head = 0, tail = 0, count = 0;
+    };
+
+    unsigned weight(size_t lane) const
+    {
+        return 1u << (queues.size() - 1 - lane);
+    }
+
+    size_t take(size_t lane, T &item)
+    {
+        Lane &q = queues[lane];
+        size_t pos = q.head;
+        item = q.slots[pos].item;
+        q.head = (q.head + 1) % cap;
+        q.count--;
+        count--;
+        return pos;
+    }
+
+    // Non-empty lane whose first item has waited longest
+    size_t oldestLane() const
+    {
+        size_t n = queues.size();
+        size_t oldest = n;
+        for (size_t l = 0; l < n; l++)
+            if (queues[l].count > 0 &&
+                (oldest == n || queues[l].slots[queues[l].head].enqueued < queues[oldest].slots[queues[oldest].head].enqueued))
+                oldest = l;
+        return oldest;
+    }
+
+    // Non-empty lane whose last item went in most recently
+    size_t newestLane() const
+    {
+        size_t n = queues.size();
+        size_t newest = n;
+        for (size_t l = 0; l < n; l++)
+            if (queues[l].count > 0 && (newest == n || last(l).enqueued > last(newest).enqueued))
+                newest = l;
+        return newest;
+    }
+
+    const Entry &last(size_t lane) const
+    {
+        const Lane &q = queues[lane];
+        return q.slots[(q.tail + cap - 1) % cap];
+    }
+
+    size_t pick(long long nowNs)
+    {
+        if (agingNs > 0)
+        {
+            size_t oldest = oldestLane();
+            if (nowNs - queues[oldest].slots[queues[oldest].head].enqueued >= agingNs)
+            {
+                // Only an item that would not have been picked anyway counts as aged
+                size_t chosen = policy == LanePolicy::Strict ? firstNonEmpty() : nextTurn(false);
+                if (chosen != oldest)
+                {
+                    aged++;
+                    return oldest;
+                }
+            }
+        }
+        return policy == LanePolicy::Strict ? firstNonEmpty() : nextTurn(true);
+    }
+
+    size_t firstNonEmpty() const
+    {
+        size_t l = 0;
+        while (queues[l].count == 0)
+            l++;
+        return l;
+    }
+
+    // Lane whose turn it is; with consume, uses up one item of its turn
+    size_t nextTurn(bool consume)
+    {
+        size_t n = queues.size();
+        size_t lane = current;
+        unsigned left = credit;
+        // Some lane is non-empty, so this ends within one round
+        while (left == 0 || queues[lane].count == 0)
+        {
+            lane = (lane + 1) % n;
+            left = weight(lane);
+        }
+        if (consume)
+        {
+            current = lane;
+            credit = left - 1;
+        }
+        return lane;
+    }
+
+    const size_t cap;
+    const LanePolicy policy;
+    const long long agingNs;
+    std::vector<Lane> queues;
+    size_t count = 0;
+    size_t current = 0;
+    unsigned credit = 0;
+    long long aged = 0;
+};
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef SHARDED_BUFFER_H
+#define SHARDED_BUFFER_H
+
+// Bounded buffer split into S independent MPMC rings (mpmc_ring.h) so that
+// many producers and consumers do not all contend on one pair of counters.
+//
+// A producer picks two shards at random and pushes into the one holding
+// fewer items ("power of two choices"), which keeps the shards about equally
+// full without any shared state; only when both are full does it try the
+// others in turn. A consumer pops from its home shard and, when that one is
+// empty, steals from the others, starting with the next shard.
+//
+// Items stay in FIFO order within a shard but not across shards. Like the
+// rings, tryPush/tryPop never block; false means every shard was full (empty)
+// when it was tried.
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "mpmc_ring.h"
+
+template <typename T>
+class ShardedBuffer
+{
+public:
+    // capacity is the total, spread over the shards as evenly as it goes
+    // (the first capacity % shards shards get one slot more). An MpmcRing
+    // needs two slots, so with fewer than two slots per shard the total is
+    // larger than asked for; capacity() tells the real total.
+    ShardedBuffer(size_t shards, size_t capacity)
+    {
+        if (shards < 1)
+            shards = 1;
+        for (size_t i = 0; i < shards; i++)
+        {
+            size_t slots = capacity / shards + (i < capacity % shards ? 1 : 0);
+            rings.emplace_back(new MpmcRing<T>(slots < 2 ? 2 : slots));
+        }
+    }
+
+    ShardedBuffer(const ShardedBuffer &) = delete;
+    ShardedBuffer &operator=(const ShardedBuffer &) = delete;
+
+    size_t shardCount() const
+    {
+        return rings.size();
+    }
+
+    size_t capacity() const
+    {
+        size_t total = 0;
+        for (const std::unique_ptr<MpmcRing<T>> &r : rings)
+            total += r->capacity();
+        return total;
+    }
+
+    // rng is the calling thread's own xorshift state (any nonzero value to
+    // start with); on success shard is where the item went
+    bool tryPush(const T &item, uint32_t &rng, size_t &shard)
+    {
+        size_t n = rings.size();
+        size_t a = next(rng) % n;
+        size_t b = n > 1 ? (a + 1 + next(rng) % (n - 1)) % n : a;
+        if (rings[b]->sizeApprox() < rings[a]->sizeApprox())
+            std::swap(a, b);
+        size_t pos;
+        if (rings[a]->tryPush(item, pos))
+        {
+            shard = a;
+            return true;
+        }
+        if (b != a && rings[b]->tryPush(item, pos))
+        {
+            shard = b;
+            return true;
+        }
+        for (size_t i = 1; i < n; i++)
+        {
+            size_t s = (a + i) % n;
+            if (s != b && rings[s]->tryPush(item, pos))
+            {
+                shard = s;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // home is the consumer's own shard (any index; taken modulo S); on
+    // success shard is where the item came from
+    bool tryPop(T &item, size_t home, size_t &shard)
+    {
+        size_t n = rings.size();
+        size_t pos;
+        for (size_t i = 0; i < n; i++)
+        {
+            size_t s = (home + i) % n;
+            if (rings[s]->tryPop(item, pos))
+            {
+                shard = s;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    static uint32_t next(uint32_t &x)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return x;
+    }
+
+    std::vector<std::unique_ptr<MpmcRing<T>>> rings;
+};
+
+#endif
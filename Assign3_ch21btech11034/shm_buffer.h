@@ -0,0 +1,302 @@
+#ifndef SHM_BUFFER_H
+#define SHM_BUFFER_H
+
+// Bounded buffer shared between processes. The ring, its indices and the
+// three semaphores of prod_cons-sems (created with pshared = 1) live in one
+// POSIX shared memory object, so producer and consumer processes attach to
+// it by name and exchange items without a socket or a pipe. Producers build
+// an item straight in its slot (beginPush/commitPush) and consumers read it
+// from there (beginPop/commitPop): the item is written once and read once.
+//
+// The first process to open a name creates and initializes the object; the
+// others wait until it is marked ready, check that capacity and item size
+// match, and attach. Every process counts itself in the header and the last
+// one to detach destroys the semaphores and unlinks the name. A process only
+// joins while the count is above zero (CAS, never from 0), so once the last
+// user has left nobody can attach to the object being torn down; a process
+// that finds it at zero waits for the name to go and creates a new object.
+// A process that dies without detaching leaves the object behind in /dev/shm.
+//
+// T must be trivially copyable and must not hold pointers: the slots are the
+// same memory in every process, but mapped at different addresses.
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <fcntl.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+template <typename T>
+class ShmBuffer
+{
+    static_assert(std::is_trivially_copyable<T>::value, "items are shared between processes as raw bytes");
+
+public:
+    // Opens the buffer called name ("/something"), creating it with the given
+    // capacity if it does not exist yet. Throws std::runtime_error on failure.
+    ShmBuffer(const std::string &name, size_t capacity) : name(name)
+    {
+        if (capacity < 1)
+            throw std::runtime_error("capacity must be positive");
+        for (int tries = 0;; tries++)
+        {
+            int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+            if (fd >= 0)
+            {
+                create(fd, capacity);
+                return;
+            }
+            if (errno != EEXIST)
+                fail("shm_open");
+            if (attach(capacity))
+                return;
+            // The last user is detaching; start over once the name is gone
+            if (tries == 5000)
+                throw std::runtime_error(name + " is being removed but was never unlinked");
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    ~ShmBuffer()
+    {
+        release();
+    }
+
+    ShmBuffer(const ShmBuffer &) = delete;
+    ShmBuffer &operator=(const ShmBuffer &) = delete;
+
+    size_t capacity() const
+    {
+        return header->capacity;
+    }
+
+    // True in the process that created the object
+    bool creator() const
+    {
+        return isCreator;
+    }
+
+    // steady_clock time (ns since its epoch, the same in every process on
+    // the machine) at which the buffer was created
+    long long baseNs() const
+    {
+        return header->base_ns;
+    }
+
+    // Waits for a free slot and the buffer mutex and returns the slot to fill
+    // in place; pos is its index. Must be followed by commitPush().
+    T *beginPush(size_t &pos)
+    {
+        sem_wait(&header->sem_empty);
+        sem_wait(&header->sem_mutex);
+        pos = header->in_index;
+        return &slots[pos];
+    }
+
+    void commitPush()
+    {
+        header->in_index = (header->in_index + 1) % header->capacity;
+        sem_post(&header->sem_mutex);
+        sem_post(&header->sem_full);
+    }
+
+    // Waits for an item and the buffer mutex and returns the slot holding
+    // it; the slot stays valid until commitPop()
+    const T *beginPop(size_t &pos)
+    {
+        sem_wait(&header->sem_full);
+        sem_wait(&header->sem_mutex);
+        pos = header->out_index;
+        return &slots[pos];
+    }
+
+    void commitPop()
+    {
+        header->out_index = (header->out_index + 1) % header->capacity;
+        sem_post(&header->sem_mutex);
+        sem_post(&header->sem_empty);
+    }
+
+private:
+    static const unsigned MAGIC = 0x5348424du; // "SHBM"
+    static const unsigned DEAD = 0x44454144u;  // "DEAD", set by the last user
+
+    struct Header
+    {
+        std::atomic<unsigned> ready; // MAGIC once initialized, DEAD once torn down
+        std::atomic<int> users;
+        size_t capacity;
+        size_t itemSize;
+        long long base_ns;
+        sem_t sem_empty;
+        sem_t sem_full;
+        sem_t sem_mutex;
+        size_t in_index;
+        size_t out_index;
+    };
+
+    static_assert(std::atomic<unsigned>::is_always_lock_free && std::atomic<int>::is_always_lock_free,
+                  "the header atomics are shared between processes");
+
+    // Slots start on the cache line after the header
+    static size_t slotsOffset()
+    {
+        return (sizeof(Header) + 63) / 64 * 64;
+    }
+
+    static size_t regionSize(size_t capacity)
+    {
+        return slotsOffset() + capacity * sizeof(T);
+    }
+
+    [[noreturn]] void fail(const std::string &what)
+    {
+        throw std::runtime_error(what + " " + name + ": " + std::strerror(errno));
+    }
+
+    // Drops this process's count and unmaps; the last user tears down
+    void release()
+    {
+        if (header->users.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            // No one can join from 0; this tells processes still waiting
+            // for ready to start over
+            header->ready.store(DEAD, std::memory_order_release);
+            sem_destroy(&header->sem_empty);
+            sem_destroy(&header->sem_full);
+            sem_destroy(&header->sem_mutex);
+            shm_unlink(name.c_str());
+        }
+        munmap(region, mappedSize);
+    }
+
+    void map(int fd, size_t size)
+    {
+        void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            close(fd);
+            fail("mmap");
+        }
+        region = p;
+        mappedSize = size;
+        header = static_cast<Header *>(p);
+        slots = reinterpret_cast<T *>(static_cast<char *>(p) + slotsOffset());
+    }
+
+    void create(int fd, size_t capacity)
+    {
+        if (ftruncate(fd, regionSize(capacity)) != 0)
+        {
+            close(fd);
+            shm_unlink(name.c_str());
+            fail("ftruncate");
+        }
+        map(fd, regionSize(capacity));
+        close(fd);
+        isCreator = true;
+
+        // The new object is zero-filled, so ready reads 0 until the end
+        header->users.store(1, std::memory_order_relaxed);
+        header->capacity = capacity;
+        header->itemSize = sizeof(T);
+        header->base_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch())
+                              .count();
+        sem_init(&header->sem_empty, 1, capacity);
+        sem_init(&header->sem_full, 1, 0);
+        sem_init(&header->sem_mutex, 1, 1);
+        header->in_index = 0;
+        header->out_index = 0;
+        header->ready.store(MAGIC, std::memory_order_release);
+    }
+
+    // False if the object turned out to be on its way out
+    bool attach(size_t capacity)
+    {
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0)
+        {
+            // Unlinked since the O_EXCL open failed
+            if (errno == ENOENT)
+                return false;
+            fail("shm_open");
+        }
+        // The creator may not have sized or initialized the object yet
+        struct stat st;
+        for (int tries = 0;; tries++)
+        {
+            if (fstat(fd, &st) != 0)
+            {
+                close(fd);
+                fail("fstat");
+            }
+            if (static_cast<size_t>(st.st_size) >= slotsOffset())
+                break;
+            if (tries == 5000)
+            {
+                close(fd);
+                throw std::runtime_error(name + " exists but was never initialized (stale object in /dev/shm?)");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        map(fd, st.st_size);
+        close(fd);
+        for (int tries = 0; header->ready.load(std::memory_order_acquire) != MAGIC; tries++)
+        {
+            if (header->ready.load(std::memory_order_acquire) == DEAD)
+            {
+                munmap(region, mappedSize);
+                return false;
+            }
+            if (tries == 5000)
+            {
+                munmap(region, mappedSize);
+                throw std::runtime_error(name + " exists but was never initialized (stale object in /dev/shm?)");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (header->capacity != capacity || header->itemSize != sizeof(T) ||
+            static_cast<size_t>(st.st_size) < regionSize(capacity))
+        {
+            munmap(region, mappedSize);
+            throw std::runtime_error(name + " was created with a different capacity or item type");
+        }
+        // Join only while someone else still holds the object
+        int users = header->users.load(std::memory_order_relaxed);
+        do
+        {
+            if (users == 0)
+            {
+                munmap(region, mappedSize);
+                return false;
+            }
+        } while (!header->users.compare_exchange_weak(users, users + 1, std::memory_order_acq_rel));
+        // With the count taken the object can no longer be torn down; back
+        // out if it was anyway before the count went up
+        if (header->ready.load(std::memory_order_acquire) != MAGIC)
+        {
+            release();
+            return false;
+        }
+        return true;
+    }
+
+    const std::string name;
+    bool isCreator = false;
+    void *region = nullptr;
+    size_t mappedSize = 0;
+    Header *header = nullptr;
+    T *slots = nullptr;
+};
+
+#endif
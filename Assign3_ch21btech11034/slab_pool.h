@@ -0,0 +1,140 @@
+#ifndef SLAB_POOL_H
+#define SLAB_POOL_H
+
+// Fixed-size slab pool for large producer-consumer messages. All slabs come
+// from one allocation made up front; a producer takes a slab, fills it in
+// place and passes only its 32-bit handle through the buffer, and the
+// consumer gives the slab back once it is done with it. Nothing is malloc'ed
+// or freed per message, so the allocator never sees memory allocated on one
+// thread and freed on another.
+//
+// Every thread works through its own SlabPool::Cache. Allocations and
+// releases hit the cache; only when it runs empty (or full) does the thread
+// lock the shared free list and move half a cache's worth of handles at once.
+// With producers only allocating and consumers only releasing, slabs travel
+// from consumer caches back to producer caches in those batches.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct SlabHandle
+{
+    uint32_t index;
+};
+
+class SlabPool
+{
+public:
+    SlabPool(size_t slabSize, size_t slabCount)
+        : slabSize(roundUp(slabSize)), slabCount(slabCount),
+          memory(new unsigned char[this->slabSize * slabCount + 63])
+    {
+        // Slabs start on a cache line so two of them never share one
+        uintptr_t raw = reinterpret_cast<uintptr_t>(memory.get());
+        base = memory.get() + ((64 - raw % 64) % 64);
+        freeList.reserve(slabCount);
+        for (size_t i = slabCount; i > 0; i--)
+            freeList.push_back(static_cast<uint32_t>(i - 1));
+    }
+
+    SlabPool(const SlabPool &) = delete;
+    SlabPool &operator=(const SlabPool &) = delete;
+
+    void *data(SlabHandle h) const
+    {
+        return base + static_cast<size_t>(h.index) * slabSize;
+    }
+
+    size_t size() const
+    {
+        return slabSize;
+    }
+
+    size_t count() const
+    {
+        return slabCount;
+    }
+
+    // Per-thread front end; must not be shared between threads. Handles still
+    // cached when it is destroyed go back to the pool.
+    class Cache
+    {
+    public:
+        explicit Cache(SlabPool &pool, size_t capacity = 64) : pool(pool), capacity(std::max<size_t>(capacity, 2))
+        {
+            handles.reserve(this->capacity);
+        }
+
+        ~Cache()
+        {
+            pool.give(handles, handles.size());
+        }
+
+        Cache(const Cache &) = delete;
+        Cache &operator=(const Cache &) = delete;
+
+        // False when every slab is in use (the caller waits for a consumer)
+        bool tryAllocate(SlabHandle &h)
+        {
+            if (handles.empty() && pool.take(handles, capacity / 2) == 0)
+                return false;
+            h.index = handles.back();
+            handles.pop_back();
+            return true;
+        }
+
+        void release(SlabHandle h)
+        {
+            if (handles.size() == capacity)
+                pool.give(handles, capacity / 2);
+            handles.push_back(h.index);
+        }
+
+        void *data(SlabHandle h) const
+        {
+            return pool.data(h);
+        }
+
+    private:
+        SlabPool &pool;
+        const size_t capacity;
+        std::vector<uint32_t> handles;
+    };
+
+private:
+    static size_t roundUp(size_t n)
+    {
+        return (std::max<size_t>(n, 1) + 63) / 64 * 64;
+    }
+
+    // Moves up to n handles from the shared free list to the end of out
+    size_t take(std::vector<uint32_t> &out, size_t n)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        n = std::min(n, freeList.size());
+        out.insert(out.end(), freeList.end() - n, freeList.end());
+        freeList.resize(freeList.size() - n);
+        return n;
+    }
+
+    // Moves the last n handles of from back to the shared free list
+    void give(std::vector<uint32_t> &from, size_t n)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        freeList.insert(freeList.end(), from.end() - n, from.end());
+        from.resize(from.size() - n);
+    }
+
+    const size_t slabSize;
+    const size_t slabCount;
+    std::unique_ptr<unsigned char[]> memory;
+    unsigned char *base;
+    std::mutex lock;
+    std::vector<uint32_t> freeList;
+};
+
+#endif
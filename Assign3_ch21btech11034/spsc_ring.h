@@ -0,0 +1,78 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+// Bounded single-producer single-consumer ring. Only the producer writes
+// tail and only the consumer writes head, so both sides get by with plain
+// acquire loads and release stores: no CAS, no fetch_add, no lock. Each side
+// also keeps a private copy of the other side's index and only reloads the
+// shared one when the copy says the ring is full (or empty), which keeps the
+// cache line of the other index from bouncing on every item.
+//
+// Using it from more than one producer or more than one consumer is a bug.
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+template <typename T>
+class SpscRing
+{
+public:
+    explicit SpscRing(size_t capacity) : cap(capacity), slots(capacity)
+    {
+    }
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    size_t capacity() const
+    {
+        return cap;
+    }
+
+    // Producer only; on success pos is the slot the item went into
+    bool tryPush(const T &item, size_t &pos)
+    {
+        unsigned long long t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead == cap)
+        {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead == cap)
+                return false;
+        }
+        pos = t % cap;
+        slots[pos] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only; on success pos is the slot the item came from
+    bool tryPop(T &item, size_t &pos)
+    {
+        unsigned long long h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail)
+        {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail)
+                return false;
+        }
+        pos = h % cap;
+        item = slots[pos];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    const size_t cap;
+    std::vector<T> slots;
+
+    // Consumer side: its index and its copy of the producer's
+    alignas(64) std::atomic<unsigned long long> head{0};
+    unsigned long long cachedTail = 0;
+
+    // Producer side: its index and its copy of the consumer's
+    alignas(64) std::atomic<unsigned long long> tail{0};
+    unsigned long long cachedHead = 0;
+};
+
+#endif